@@ -69,6 +69,7 @@ ApplicationHelper::Install (Ptr<Node> clientNode, Ptr<Node> serverNode,
 
   InetSocketAddress clientInetAddr (clientAddr, port);
   // clientInetAddr.SetTos (Dscp2Tos (dscp));
+  serverApp->SetAttribute ("LocalAddress", Ipv4AddressValue (serverAddr));
   serverApp->SetAttribute ("LocalPort", UintegerValue (port));
   serverApp->SetClient (clientApp, clientInetAddr);
   serverNode->AddApplication (serverApp);
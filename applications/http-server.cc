@@ -86,7 +86,7 @@ HttpServer::StartApplication ()
   NS_LOG_INFO ("Creating the listening TCP socket.");
   TypeId tcpFactory = TypeId::LookupByName ("ns3::TcpSocketFactory");
   m_socket = Socket::CreateSocket (GetNode (), tcpFactory);
-  m_socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), m_localPort));
+  m_socket->Bind (InetSocketAddress (m_localAddress, m_localPort));
   m_socket->Listen ();
   m_socket->SetAcceptCallback (
     MakeCallback (&HttpServer::NotifyConnectionRequest, this),
@@ -255,6 +255,15 @@ SvelteClient::Start ()
   m_appStartTrace (this);
 }
 
+void
+SvelteClient::Preempt ()
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_INFO ("Client application preempted.");
+
+  ForceStop ();
+}
+
 void
 SvelteClient::DoDispose (void)
 {
@@ -284,12 +293,26 @@ SvelteClient::ForceStop ()
   m_serverApp->NotifyForceStop ();
 }
 
+Time
+SvelteClient::GetExpectedLength ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_nextLength.IsZero ())
+    {
+      m_nextLength = Seconds (std::abs (m_lengthRng->GetValue ()));
+    }
+  return m_nextLength;
+}
+
 Time
 SvelteClient::GetTrafficLength ()
 {
   NS_LOG_FUNCTION (this);
 
-  return Seconds (std::abs (m_lengthRng->GetValue ()));
+  Time length = GetExpectedLength ();
+  m_nextLength = Time (0);
+  return length;
 }
 
 void
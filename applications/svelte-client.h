@@ -99,12 +99,26 @@ public:
    */
   void SetServer (Ptr<SvelteServer> serverApp, Address serverAddress);
 
+  /**
+   * Get the traffic length for the next start of this application. The value
+   * is drawn in advance, so the controller can estimate the bearer lifetime at
+   * admission, and it is the one returned by GetTrafficLength on next start.
+   * \return The random traffic length.
+   */
+  Time GetExpectedLength ();
+
   /**
    * Start this application. Reset internal counters, notify the server
    * application, fire the start trace source, and start traffic generation.
    */
   virtual void Start ();
 
+  /**
+   * Force this active application to stop because its bearer was preempted
+   * by a higher priority bearer.
+   */
+  void Preempt ();
+
   /**
    * TracedCallback signature for Ptr<SvelteClient>.
    * \param app The client application.
@@ -175,6 +189,7 @@ private:
   std::string               m_name;           //!< Application name.
   bool                      m_active;         //!< Active state.
   Ptr<RandomVariableStream> m_lengthRng;      //!< Random traffic length.
+  Time                      m_nextLength;     //!< Next traffic length.
   Time                      m_maxOnTime;      //!< Max duration time.
   EventId                   m_forceStop;      //!< Max duration stop event.
   bool                      m_forceStopFlag;  //!< Force stop flag.
@@ -54,6 +54,10 @@ SvelteServer::GetTypeId (void)
                    AddressValue (),
                    MakeAddressAccessor (&SvelteServer::m_clientAddress),
                    MakeAddressChecker ())
+    .AddAttribute ("LocalAddress", "Local address.",
+                   Ipv4AddressValue (Ipv4Address::GetAny ()),
+                   MakeIpv4AddressAccessor (&SvelteServer::m_localAddress),
+                   MakeIpv4AddressChecker ())
     .AddAttribute ("LocalPort", "Local port.",
                    UintegerValue (10000),
                    MakeUintegerAccessor (&SvelteServer::m_localPort),
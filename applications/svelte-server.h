@@ -109,6 +109,7 @@ protected:
 
   Ptr<AppStatsCalculator> m_appStats;         //!< QoS statistics.
   Ptr<Socket>             m_socket;           //!< Local socket.
+  Ipv4Address             m_localAddress;     //!< Local address.
   uint16_t                m_localPort;        //!< Local port.
   Address                 m_clientAddress;    //!< Client address.
   Ptr<SvelteClient>       m_clientApp;        //!< Client application.
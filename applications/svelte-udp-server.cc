@@ -81,7 +81,7 @@ SvelteUdpServer::StartApplication (void)
   NS_LOG_INFO ("Opening the UDP socket.");
   TypeId udpFactory = TypeId::LookupByName ("ns3::UdpSocketFactory");
   m_socket = Socket::CreateSocket (GetNode (), udpFactory);
-  m_socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), m_localPort));
+  m_socket->Bind (InetSocketAddress (m_localAddress, m_localPort));
   m_socket->Connect (InetSocketAddress::ConvertFrom (m_clientAddress));
   m_socket->SetRecvCallback (
     MakeCallback (&SvelteUdpServer::ReadPacket, this));
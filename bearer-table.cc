@@ -0,0 +1,136 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Campinas (Unicamp)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Rafael G. Motta <rafaelgmotta@gmail.com>
+ *         Luciano J. Chaves <ljerezchaves@gmail.com>
+ */
+
+#include "bearer-table.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BearerTable");
+
+BearerTable::BearerTable ()
+{
+}
+
+BearerInfo*
+BearerTable::Find (uint32_t teid)
+{
+  if (teid >= m_index.size () || !m_index [teid])
+    {
+      return 0;
+    }
+  return &m_records [m_index [teid] - 1];
+}
+
+BearerInfo*
+BearerTable::Find (Ipv4Address ipAddr, uint8_t ipProto, uint16_t port)
+{
+  auto it = m_flowIndex.find (GetFlowKey (ipAddr, ipProto, port));
+  if (it == m_flowIndex.end ())
+    {
+      return 0;
+    }
+  return Find (it->second);
+}
+
+BearerInfo&
+BearerTable::Insert (uint32_t teid, Ipv4Address ipAddr, uint8_t ipProto,
+                     uint16_t port)
+{
+  NS_LOG_FUNCTION (this << teid << ipAddr << +ipProto << port);
+
+  BearerInfo *bearer = Find (teid);
+  if (bearer)
+    {
+      return *bearer;
+    }
+
+  // TEIDs are allocated sequentially per host, so the index stays dense.
+  if (teid >= m_index.size ())
+    {
+      m_index.resize (teid + 1, 0);
+    }
+  m_records.push_back (BearerInfo ());
+  m_index [teid] = m_records.size ();
+  m_records.back ().teid = teid;
+  m_records.back ().ipAddr = ipAddr;
+  m_records.back ().ipProto = ipProto;
+  m_records.back ().port = port;
+  m_flowIndex [GetFlowKey (ipAddr, ipProto, port)] = teid;
+  return m_records.back ();
+}
+
+void
+BearerTable::Erase (uint32_t teid)
+{
+  NS_LOG_FUNCTION (this << teid);
+
+  if (!Find (teid))
+    {
+      return;
+    }
+
+  // Move the last record into the erased position to keep records contiguous.
+  uint32_t pos = m_index [teid] - 1;
+  const BearerInfo &bearer = m_records [pos];
+  m_flowIndex.erase (GetFlowKey (bearer.ipAddr, bearer.ipProto, bearer.port));
+  if (pos != m_records.size () - 1)
+    {
+      m_records [pos] = std::move (m_records.back ());
+      m_index [m_records [pos].teid] = pos + 1;
+    }
+  m_records.pop_back ();
+  m_index [teid] = 0;
+}
+
+void
+BearerTable::Clear ()
+{
+  m_index.clear ();
+  m_records.clear ();
+  m_flowIndex.clear ();
+}
+
+uint32_t
+BearerTable::GetSize () const
+{
+  return m_records.size ();
+}
+
+BearerTable::Iterator
+BearerTable::begin ()
+{
+  return m_records.begin ();
+}
+
+BearerTable::Iterator
+BearerTable::end ()
+{
+  return m_records.end ();
+}
+
+uint64_t
+BearerTable::GetFlowKey (Ipv4Address ipAddr, uint8_t ipProto, uint16_t port)
+{
+  return (static_cast<uint64_t> (ipAddr.Get ()) << 24)
+         | (static_cast<uint64_t> (ipProto) << 16) | port;
+}
+
+} // namespace ns3
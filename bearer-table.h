@@ -0,0 +1,148 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Campinas (Unicamp)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Rafael G. Motta <rafaelgmotta@gmail.com>
+ *         Luciano J. Chaves <ljerezchaves@gmail.com>
+ */
+
+#ifndef BEARER_TABLE_H
+#define BEARER_TABLE_H
+
+#include <ns3/ofswitch13-module.h>
+#include <ns3/internet-module.h>
+#include <ns3/core-module.h>
+#include "rate-estimator.h"
+#include "applications/svelte-client.h"
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+/** Metadata for an active traffic, identified by its TEID (rule cookie). */
+struct BearerInfo
+{
+  uint32_t              teid;           //!< TEID and rules cookie.
+  Ptr<SvelteClient>     app;            //!< Client application.
+  Ipv4Address           ipAddr;         //!< Client IP address.
+  uint8_t               ipProto;        //!< IP protocol (TCP or UDP).
+  uint16_t              port;           //!< Client and server port.
+  Ptr<OFSwitch13Device> switchDevice;   //!< HW/SW switch with the rules.
+  Time                  installed;      //!< Rules installation time.
+  uint8_t               entries;        //!< UL/DL entries found at the switch.
+  uint64_t              bytes;          //!< Byte count at the switch.
+  uint64_t              pkts;           //!< Packet count at the switch.
+  uint64_t              lastBytes;      //!< Last byte count.
+  uint64_t              lastPkts;       //!< Last packet count.
+  Time                  lastHit;        //!< Last time with new bytes.
+  double                hitBytes;       //!< Decayed byte count (LFU).
+  Time                  lastUpdate;     //!< Last byte count time.
+  RateEstimator         rate;           //!< Throughput estimator.
+  Time                  lastMove;       //!< Last move time (zero if never).
+  bool                  dlUlRules;      //!< Rules installed at UL/DL switches.
+  bool                  ruleWait;       //!< Rules waiting for packet-in.
+  uint32_t              group;          //!< Migration group (client index).
+  uint64_t              expected;       //!< Expected bitrate (bps).
+  Time                  endTime;        //!< Expected end time.
+};
+
+/**
+ * Dense store for active traffic records. Records are kept contiguous in
+ * memory for fast iteration, and a direct TEID index gives O(1) lookups. A
+ * hash index on the client address, IP protocol and port gives O(1) lookups
+ * for packets sent to the controller. Inserting or erasing a record may
+ * invalidate pointers to other records.
+ */
+class BearerTable
+{
+public:
+  /** Record iterator. */
+  typedef std::vector<BearerInfo>::iterator Iterator;
+
+  BearerTable ();   //!< Default constructor.
+
+  /**
+   * Get the record for this TEID.
+   * \param teid The traffic ID.
+   * \return The record pointer, or 0 when not found.
+   */
+  BearerInfo* Find (uint32_t teid);
+
+  /**
+   * Get the record for the traffic identified by its packet fields.
+   * \param ipAddr The client IP address.
+   * \param ipProto The IP protocol.
+   * \param port The client and server port.
+   * \return The record pointer, or 0 when not found.
+   */
+  BearerInfo* Find (Ipv4Address ipAddr, uint8_t ipProto, uint16_t port);
+
+  /**
+   * Get the record for this TEID, creating one with these packet fields when
+   * not found.
+   * \param teid The traffic ID.
+   * \param ipAddr The client IP address.
+   * \param ipProto The IP protocol.
+   * \param port The client and server port.
+   * \return The record reference.
+   */
+  BearerInfo& Insert (uint32_t teid, Ipv4Address ipAddr, uint8_t ipProto,
+                      uint16_t port);
+
+  /**
+   * Remove the record for this TEID, if any.
+   * \param teid The traffic ID.
+   */
+  void Erase (uint32_t teid);
+
+  /** Remove all records. */
+  void Clear ();
+
+  /**
+   * Get the number of records.
+   * \return The number of records.
+   */
+  uint32_t GetSize () const;
+
+  /**
+   * Iterators over the records, in no particular order.
+   * \return The iterator.
+   */
+  //\{
+  Iterator begin ();
+  Iterator end ();
+  //\}
+
+private:
+  /**
+   * Get the packet fields index key.
+   * \param ipAddr The client IP address.
+   * \param ipProto The IP protocol.
+   * \param port The client and server port.
+   * \return The index key.
+   */
+  static uint64_t GetFlowKey (Ipv4Address ipAddr, uint8_t ipProto,
+                              uint16_t port);
+
+  std::vector<uint32_t>   m_index;    //!< TEID to record position plus one.
+  std::vector<BearerInfo> m_records;  //!< Contiguous records.
+
+  /** Packet fields index key to TEID. */
+  std::unordered_map<uint64_t, uint32_t> m_flowIndex;
+};
+
+} // namespace ns3
+#endif  // BEARER_TABLE_H
@@ -20,14 +20,18 @@
  */
 
 #include "custom-controller.h"
+#include "rule-builder.h"
+#include "traffic-manager.h"
 #include "applications/svelte-client.h"
 #include <algorithm>
+#include <chrono>
 #include <functional>
 #include <iomanip>
 #include <iostream>
 #include <map>
 #include <ns3/ofswitch13-module.h>
 #include <set>
+#include <sstream>
 
 using namespace std;
 
@@ -37,6 +41,13 @@ NS_LOG_COMPONENT_DEFINE ("CustomController");
 NS_OBJECT_ENSURE_REGISTERED (CustomController);
 
 CustomController::CustomController ()
+  : m_hwAggTable (0),
+  m_hwBytes (0),
+  m_swBytes (0),
+  m_hwPkts (0),
+  m_swPkts (0),
+  m_barrierXid (0),
+  m_migrationId (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -62,6 +73,72 @@ CustomController::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&CustomController::m_blockPol),
                    MakeBooleanChecker ())
+    .AddAttribute ("AdmissionQueue",
+                   "Maximum number of rejected requests waiting for "
+                   "resources (0 to disable the admission queue).",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&CustomController::m_queueSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxWait",
+                   "Maximum waiting time in the admission queue.",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&CustomController::m_maxWait),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("PlacementPolicy",
+                   "Initial switch placement policy for QoS routing.",
+                   EnumValue (CustomController::SW_FIRST),
+                   MakeEnumAccessor (&CustomController::m_placement),
+                   MakeEnumChecker (CustomController::SW_FIRST, "SwFirst",
+                                    CustomController::CLASS_AWARE, "ClassAware"))
+    .AddAttribute ("ClassPreference",
+                   "Preferred switch for each traffic class under the "
+                   "ClassAware policy (Class=Hw|Sw, comma separated).",
+                   StringValue ("Realtime=Hw"),
+                   MakeStringAccessor (&CustomController::m_classPref),
+                   MakeStringChecker ())
+    .AddAttribute ("ClassHwQuota",
+                   "Maximum HW flow table usage for each traffic class under "
+                   "the ClassAware policy (Class=Usage, comma separated).",
+                   StringValue ("Realtime=0.25"),
+                   MakeStringAccessor (&CustomController::m_classQuota),
+                   MakeStringChecker ())
+    .AddAttribute ("ClassQueue",
+                   "Output queue for each traffic class at all switches "
+                   "(Class=Queue, comma separated). Unlisted classes use the "
+                   "default queue 0. An empty table disables the mapping.",
+                   StringValue (""),
+                   MakeStringAccessor (&CustomController::m_classQueue),
+                   MakeStringChecker ())
+    .AddAttribute ("MeterPolicy",
+                   "Per-bearer meter policy at HW and SW switches.",
+                   EnumValue (CustomController::NO_METER),
+                   MakeEnumAccessor (&CustomController::m_meterPol),
+                   MakeEnumChecker (CustomController::NO_METER, "None",
+                                    CustomController::METER_DROP, "Drop",
+                                    CustomController::METER_REMARK, "Remark"))
+    .AddAttribute ("MeterFactor",
+                   "Meter rate over the expected bitrate, for bearers "
+                   "without MBR.",
+                   DoubleValue (1.5),
+                   MakeDoubleAccessor (&CustomController::m_meterFactor),
+                   MakeDoubleChecker<double> (1.0))
+    .AddAttribute ("Preemption",
+                   "Preempt lower priority bearers to admit a new traffic, "
+                   "according to the EPS bearer ARP.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&CustomController::m_preemption),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PreemptTimeout",
+                   "The maximum time for a preempted application to stop.",
+                   TimeValue (Seconds (30)),
+                   MakeTimeAccessor (&CustomController::m_preemptTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("OverflowPolicy",
+                   "Route requests to the other switch when the chosen one "
+                   "is saturated (true for overflow).",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&CustomController::m_overflow),
+                   MakeBooleanChecker ())
     .AddAttribute ("SmartRouting",
                    "True for QoS routing, false for IP routing.",
                    BooleanValue (true),
@@ -72,6 +149,160 @@ CustomController::GetTypeId (void)
                    TimeValue (Seconds (15)),
                    MakeTimeAccessor (&CustomController::m_timeout),
                    MakeTimeChecker ())
+    .AddAttribute ("OffloadStrategy",
+                   "Strategy for selecting traffics to offload to HW switch.",
+                   EnumValue (OffloadPlanner::HEURISTIC),
+                   MakeEnumAccessor (&CustomController::m_offStrategy),
+                   MakeEnumChecker (OffloadPlanner::GREEDY, "Greedy",
+                                    OffloadPlanner::HEURISTIC, "Heuristic",
+                                    OffloadPlanner::EXACT, "Exact"))
+    .AddAttribute ("OffloadValue",
+                   "Value of offload candidates.",
+                   EnumValue (CustomController::THROUGHPUT),
+                   MakeEnumAccessor (&CustomController::m_offValue),
+                   MakeEnumChecker (CustomController::THROUGHPUT, "Throughput",
+                                    CustomController::REMAINING_BYTES,
+                                    "RemainingBytes"))
+    .AddAttribute ("CachePolicy",
+                   "Manage the HW switch table as a cache of the SW switch "
+                   "traffics, replacing the offload planner.",
+                   EnumValue (CustomController::NO_CACHE),
+                   MakeEnumAccessor (&CustomController::m_cachePol),
+                   MakeEnumChecker (CustomController::NO_CACHE, "None",
+                                    CustomController::CACHE_LRU, "Lru",
+                                    CustomController::CACHE_LFU, "Lfu"))
+    .AddAttribute ("CompareStrategies",
+                   "Compute the offload plans of all strategies for "
+                   "comparison, applying only the configured one.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&CustomController::m_offCompare),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ExactLimit",
+                   "Maximum number of candidates for the exact strategy.",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&CustomController::m_exactLimit),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("HighWatermark",
+                   "HW switch usage above which traffics are demoted to SW "
+                   "switch. Traffics are promoted only up to this usage.",
+                   DoubleValue (0.9),
+                   MakeDoubleAccessor (&CustomController::m_highMark),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("LowWatermark",
+                   "HW switch usage to reach when demoting traffics.",
+                   DoubleValue (0.75),
+                   MakeDoubleAccessor (&CustomController::m_lowMark),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("MinResidence",
+                   "Minimum interval between two moves of the same traffic.",
+                   TimeValue (Seconds (30)),
+                   MakeTimeAccessor (&CustomController::m_minResidence),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("IdleRate",
+                   "Throughput below which a traffic on HW switch is idle.",
+                   DataRateValue (DataRate ("8Kbps")),
+                   MakeDataRateAccessor (&CustomController::m_idleRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("AdmissionMode",
+                   "Switch CPU usage considered by admission control.",
+                   EnumValue (CustomController::REACTIVE),
+                   MakeEnumAccessor (&CustomController::m_admMode),
+                   MakeEnumChecker (CustomController::REACTIVE, "Reactive",
+                                    CustomController::PREDICTIVE, "Predictive"))
+    .AddAttribute ("LoadEstimator",
+                   "Switch CPU usage estimator for admission control.",
+                   EnumValue (LoadEstimator::INSTANT),
+                   MakeEnumAccessor (&CustomController::m_loadView),
+                   MakeEnumChecker (LoadEstimator::INSTANT, "Instant",
+                                    LoadEstimator::EWMA, "Ewma",
+                                    LoadEstimator::PEAK, "Peak",
+                                    LoadEstimator::PERCENTILE, "Percentile"))
+    .AddAttribute ("LoadSampling",
+                   "Interval between switch CPU usage samples.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&CustomController::m_loadSampling),
+                   MakeTimeChecker (MilliSeconds (1)))
+    .AddAttribute ("LoadAlpha",
+                   "Weight for the newest sample in the switch load EWMA.",
+                   DoubleValue (0.2),
+                   MakeDoubleAccessor (&CustomController::m_loadAlpha),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("LoadWindow",
+                   "Window for switch load peak and percentile.",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&CustomController::m_loadWindow),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("LoadPercentile",
+                   "Percentile for the switch load estimator.",
+                   DoubleValue (0.95),
+                   MakeDoubleAccessor (&CustomController::m_loadPct),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("MigrationMode",
+                   "Mechanism for moving traffics between HW and SW switches.",
+                   EnumValue (CustomController::RULES),
+                   MakeEnumAccessor (&CustomController::m_migMode),
+                   MakeEnumChecker (CustomController::RULES, "Rules",
+                                    CustomController::GROUPS, "Groups"))
+    .AddAttribute ("InstallMode",
+                   "Rule installation mode at HW and SW switches.",
+                   EnumValue (CustomController::PROACTIVE_RULES),
+                   MakeEnumAccessor (&CustomController::m_install),
+                   MakeEnumChecker (CustomController::PROACTIVE_RULES, "Proactive",
+                                    CustomController::REACTIVE_RULES, "Reactive"))
+    .AddAttribute ("MissSendLen",
+                   "Packet bytes sent to the controller on table-miss in "
+                   "reactive mode. Longer packets are buffered at the switch.",
+                   UintegerValue (128),
+                   MakeUintegerAccessor (&CustomController::m_missLen),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("RuleBenchmark",
+                   "Number of bearers whose rules are built through both the "
+                   "dpctl string and the binary paths when the UL switch "
+                   "connects (0 to disable).",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&CustomController::m_ruleBench),
+                   MakeUintegerChecker<uint32_t> (0, 32768))
+    .AddAttribute ("DrainTime",
+                   "Interval between the confirmed UL/DL redirection and the "
+                   "removal of rules from the source switch on migrations.",
+                   TimeValue (MilliSeconds (50)),
+                   MakeTimeAccessor (&CustomController::m_drainTime),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("EventRebalance",
+                   "Rebalance HW and SW switches as soon as any of them "
+                   "gets overloaded, not only on controller timeout.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&CustomController::m_eventRebal),
+                   MakeBooleanChecker ())
+    .AddAttribute ("RebalanceGap",
+                   "Minimum interval between consecutive rebalances.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&CustomController::m_rebalGap),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("RateEstimator",
+                   "Traffic throughput estimator.",
+                   EnumValue (RateEstimator::EWMA),
+                   MakeEnumAccessor (&CustomController::m_rateMode),
+                   MakeEnumChecker (RateEstimator::LIFETIME, "Lifetime",
+                                    RateEstimator::EWMA, "Ewma",
+                                    RateEstimator::WINDOW, "Window"))
+    .AddAttribute ("EwmaAlpha",
+                   "Weight of the newest sample for the EWMA estimator, "
+                   "for a sample covering one controller timeout.",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&CustomController::m_ewmaAlpha),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("RateWindow",
+                   "Window length for the sliding window estimator.",
+                   TimeValue (Seconds (30)),
+                   MakeTimeAccessor (&CustomController::m_rateWindow),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("BatchWindow",
+                   "Interval for coalescing OpenFlow messages to the same "
+                   "switch (zero for the same simulation timestamp).",
+                   TimeValue (Time (0)),
+                   MakeTimeAccessor (&CustomController::m_batchWindow),
+                   MakeTimeChecker (Time (0)))
 
     .AddTraceSource ("Request", "The request trace source.",
                      MakeTraceSourceAccessor (&CustomController::m_requestTrace),
@@ -79,6 +310,45 @@ CustomController::GetTypeId (void)
     .AddTraceSource ("Release", "The release trace source.",
                      MakeTraceSourceAccessor (&CustomController::m_releaseTrace),
                      "ns3::CustomController::ReleaseTracedCallback")
+    .AddTraceSource ("ReleaseDeletes", "The release deletes trace source.",
+                     MakeTraceSourceAccessor (&CustomController::m_deleteTrace),
+                     "ns3::CustomController::DeleteTracedCallback")
+    .AddTraceSource ("RuleBatch", "The rule batch trace source.",
+                     MakeTraceSourceAccessor (&CustomController::m_batchTrace),
+                     "ns3::CustomController::BatchTracedCallback")
+    .AddTraceSource ("OffloadPlan", "The offload plan trace source.",
+                     MakeTraceSourceAccessor (&CustomController::m_offloadTrace),
+                     "ns3::CustomController::OffloadTracedCallback")
+    .AddTraceSource ("Rebalance", "The rebalance trace source.",
+                     MakeTraceSourceAccessor (&CustomController::m_rebalanceTrace),
+                     "ns3::CustomController::RebalanceTracedCallback")
+    .AddTraceSource ("Overload", "The switch overload trace source.",
+                     MakeTraceSourceAccessor (&CustomController::m_overloadTrace),
+                     "ns3::CustomController::OverloadTracedCallback")
+    .AddTraceSource ("Migration", "The migration trace source.",
+                     MakeTraceSourceAccessor (&CustomController::m_migrationTrace),
+                     "ns3::CustomController::MigrationTracedCallback")
+    .AddTraceSource ("Overflow", "The overflow trace source.",
+                     MakeTraceSourceAccessor (&CustomController::m_overflowTrace),
+                     "ns3::CustomController::OverflowTracedCallback")
+    .AddTraceSource ("Preemption", "The preemption trace source.",
+                     MakeTraceSourceAccessor (&CustomController::m_preemptTrace),
+                     "ns3::CustomController::PreemptTracedCallback")
+    .AddTraceSource ("AdmissionWait", "The admission queue trace source.",
+                     MakeTraceSourceAccessor (&CustomController::m_waitTrace),
+                     "ns3::CustomController::WaitTracedCallback")
+    .AddTraceSource ("SwitchLoad", "The switch load trace source.",
+                     MakeTraceSourceAccessor (&CustomController::m_loadTrace),
+                     "ns3::CustomController::LoadTracedCallback")
+    .AddTraceSource ("PacketIn", "The packet-in trace source.",
+                     MakeTraceSourceAccessor (&CustomController::m_packetInTrace),
+                     "ns3::CustomController::PacketInTracedCallback")
+    .AddTraceSource ("RuleSetup", "The reactive rule setup trace source.",
+                     MakeTraceSourceAccessor (&CustomController::m_setupTrace),
+                     "ns3::CustomController::SetupTracedCallback")
+    .AddTraceSource ("RuleBenchmark", "The rule benchmark trace source.",
+                     MakeTraceSourceAccessor (&CustomController::m_benchTrace),
+                     "ns3::CustomController::BenchmarkTracedCallback")
   ;
   return tid;
 }
@@ -88,18 +358,57 @@ CustomController::DedicatedBearerRequest (Ptr<SvelteClient> app, uint64_t imsi)
 {
   NS_LOG_FUNCTION (this << app << imsi);
 
-  // Salvando o endereço IP do cliente para este TEID.
+  uint32_t teid = app->GetTeid ();
+  if (AdmitBearer (app))
+    {
+      m_requestTrace (teid, true);
+      return true;
+    }
+
+  // Com a fila de admissão, a requisição rejeitada aguarda por recursos e o
+  // resultado só é reportado quando ela for aceita ou descartada.
+  if (!EnqueueRequest (app))
+    {
+      m_requestTrace (teid, false);
+    }
+  return false;
+}
+
+bool
+CustomController::AdmitBearer (Ptr<SvelteClient> app)
+{
+  NS_LOG_FUNCTION (this << app);
+
+  // Recuperando o endereço IP do cliente para este TEID.
   uint32_t teid = app->GetTeid ();
   Ptr<Ipv4> ipv4 = app->GetNode ()->GetObject<Ipv4>();
   Ipv4Address ipv4addr = ipv4->GetAddress (1,0).GetLocal ();
-  m_teidAddr [teid] = ipv4addr;
 
   // Definindo o switch (HW/SW) que irá receber este tráfego.
   Ptr<OFSwitch13Device> switchDevice;
+  bool pinned = false;
   if (m_qosRoute)
     {
-      // Para o roteamento por QoS, o switch padrão é o SW.
+      // Para o roteamento por QoS, o switch padrão é o SW. Na migração por
+      // grupos, todos os tráfegos do cliente ficam no switch do seu grupo.
       switchDevice = switchDeviceSw;
+      auto it = m_groups.find (teid >> 4);
+      if (m_migMode == CustomController::GROUPS && it != m_groups.end ())
+        {
+          switchDevice = it->second.switchDevice;
+          pinned = true;
+        }
+
+      // Na alocação por classe, os tráfegos das classes que preferem o switch
+      // HW começam nele enquanto a classe estiver dentro da sua cota. Na
+      // migração por grupos, o primeiro tráfego do cliente define o switch do
+      // grupo, que prevalece para os demais.
+      TrafficClass cls = GetTrafficClass (teid);
+      if (m_placement == CustomController::CLASS_AWARE && !pinned
+          && m_classHw [cls] && HasHwQuota (cls))
+        {
+          switchDevice = switchDeviceHw;
+        }
     }
   else
     {
@@ -109,73 +418,239 @@ CustomController::DedicatedBearerRequest (Ptr<SvelteClient> app, uint64_t imsi)
       switchDevice = ipImpar ? switchDeviceSw : switchDeviceHw;
     }
 
-  // Verifica os recursos disponíveis no switch (processamento e uso de tabela)
-  double tabUse = switchDevice->GetFlowTableUsage (0);
-  double cpuUse = switchDevice->GetCpuUsage ();
+  // Switch para onde as regras padrão dos switches UL e DL levam o tráfego.
+  Ptr<OFSwitch13Device> routeDevice = switchDevice;
+  if (m_qosRoute && !pinned)
+    {
+      routeDevice = switchDeviceSw;
+    }
 
-  // Bloquear o tráfego se a tabela exceder o limite de bloqueio.
-  if (tabUse > m_blockThs)
+  // Verifica os recursos disponíveis no switch escolhido.
+  uint64_t expected = GetExpectedRate (teid).GetBitRate ();
+  bool overflow = false;
+  if (!HasResources (switchDevice, expected))
+    {
+      // Na política de transbordo, o tráfego segue para o outro switch quando
+      // ele tiver recursos, e só é bloqueado quando ambos estão cheios. Um
+      // cliente com grupo de migração fica preso ao switch do seu grupo.
+      Ptr<OFSwitch13Device> otherDevice =
+        switchDevice == switchDeviceSw ? switchDeviceHw : switchDeviceSw;
+      if (m_overflow && !pinned && HasResources (otherDevice, expected))
+        {
+          switchDevice = otherDevice;
+          overflow = true;
+        }
+      else if (!PreemptBearers (switchDevice, app, expected))
+        {
+          return false;
+        }
+    }
+
+  // Salvando os metadados do tráfego. Estamos considerando os valores
+  // manualmente adicionados ao TEID para identificar a aplicação: as 3
+  // primeiras são TCP, e as demais UDP. A porta é a mesma usada pela aplicação.
+  UintegerValue portValue;
+  app->GetAttribute ("LocalPort", portValue);
+
+  BearerInfo &bearer = m_bearers.Insert (
+      teid, ipv4addr, (teid & 0xF) <= 3 ? 6 : 17, portValue.Get ());
+  bearer.rate.Configure (m_rateMode, m_ewmaAlpha, m_timeout, m_rateWindow,
+                         Simulator::Now ());
+  bearer.lastMove = Time (0);
+  bearer.dlUlRules = false;
+  bearer.ruleWait = false;
+  bearer.group = teid >> 4;
+  bearer.app = app;
+  bearer.expected = expected;
+  bearer.endTime = GetExpectedEnd (app);
+  bearer.lastHit = Simulator::Now ();
+  bearer.hitBytes = 0;
+
+  // Instalar as regras para este tráfego.
+  if (m_qosRoute && m_migMode == CustomController::GROUPS)
+    {
+      InstallGroupRules (switchDevice, bearer);
+    }
+  if (m_install == CustomController::REACTIVE_RULES)
+    {
+      // No modo reativo, as regras só serão instaladas no primeiro
+      // packet-in, mas os recursos do switch já ficam reservados.
+      SetBearerSwitch (bearer, switchDevice);
+      bearer.ruleWait = true;
+    }
+  else
+    {
+      InstallTrafficRules (switchDevice, teid);
+    }
+
+  // Fora das regras padrão, como na alocação por classe ou no transbordo, os
+  // switches UL e DL precisam de regras específicas para este tráfego. Na
+  // migração por grupos, o grupo do cliente já faz este redirecionamento.
+  if (switchDevice != routeDevice
+      && !(m_qosRoute && m_migMode == CustomController::GROUPS))
+    {
+      UpdateDlUlRules (teid);
+    }
+  if (overflow)
+    {
+      m_overflowTrace (teid, switchDevice->GetDatapathId ());
+    }
+  return true;
+}
+
+bool
+CustomController::EnqueueRequest (Ptr<SvelteClient> app)
+{
+  NS_LOG_FUNCTION (this << app);
+
+  if (m_queueSize == 0)
     {
-      m_requestTrace (teid, false);
       return false;
     }
 
-  // Bloquear o tráfego se o uso de cpu exceder o limite de bloqueio e a
-  // política de bloqueio por excesso de carga estiver ativa.
-  if (cpuUse > m_blockThs && m_blockPol)
+  // A espera é limitada para que a aplicação ainda tenha tempo de tráfego
+  // antes da sua próxima tentativa de início.
+  Ptr<TrafficManager> manager = app->GetNode ()->GetObject<TrafficManager> ();
+  Time now = Simulator::Now ();
+  Time deadline = std::min (now + m_maxWait, manager->GetDeferredDeadline (app));
+  if (deadline <= now)
     {
-      m_requestTrace (teid, false);
       return false;
     }
 
-  // Instalar as regras para este tráfego.
-  InstallTrafficRules (switchDevice, teid);
-  m_requestTrace (teid, true);
+  // A fila prioriza os tráfegos de menor vazão esperada, que ocupam menos
+  // recursos quando liberados. Com a fila cheia, a requisição de menor
+  // prioridade é descartada.
+  uint64_t expected = GetExpectedRate (app->GetTeid ()).GetBitRate ();
+  if (m_pending.size () >= m_queueSize)
+    {
+      auto last = std::prev (m_pending.end ());
+      if (expected >= last->first)
+        {
+          return false;
+        }
+      uint32_t lastTeid = last->second.app->GetTeid ();
+      m_waitTrace (lastTeid, now - last->second.arrival, false);
+      m_requestTrace (lastTeid, false);
+      m_pending.erase (last);
+    }
+
+  PendingRequest request;
+  request.app = app;
+  request.arrival = now;
+  request.deadline = deadline;
+  m_pending.insert (std::make_pair (expected, request));
   return true;
 }
 
+void
+CustomController::ProcessPendingRequests ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  auto it = m_pending.begin ();
+  while (it != m_pending.end ())
+    {
+      PendingRequest &request = it->second;
+      uint32_t teid = request.app->GetTeid ();
+
+      // Descartando as requisições que excederam a espera máxima.
+      if (now > request.deadline)
+        {
+          m_waitTrace (teid, request.deadline - request.arrival, false);
+          m_requestTrace (teid, false);
+          it = m_pending.erase (it);
+          continue;
+        }
+
+      // Aceitando as requisições que agora cabem nos switches. O gerente de
+      // tráfego inicia a aplicação que havia sido rejeitada.
+      if (AdmitBearer (request.app))
+        {
+          Ptr<TrafficManager> manager =
+            request.app->GetNode ()->GetObject<TrafficManager> ();
+          manager->AppStartDeferred (request.app);
+          m_bearers.Find (teid)->endTime = GetExpectedEnd (request.app);
+          m_waitTrace (teid, now - request.arrival, true);
+          m_requestTrace (teid, true);
+          it = m_pending.erase (it);
+          continue;
+        }
+      ++it;
+    }
+}
+
 bool
 CustomController::DedicatedBearerRelease (Ptr<SvelteClient> app, uint64_t imsi)
 {
   NS_LOG_FUNCTION (this << app << imsi);
 
-  // Removendo potenciais regras de todos os switches.
+  // Um tráfego preemptado mantém suas regras até a parada da aplicação, que
+  // só ocorre após o objeto TCP em curso ser recebido. As regras são então
+  // removidas uma única vez, aqui.
   uint32_t teid = app->GetTeid ();
-  RemoveTrafficRules (switchDeviceSw, teid);
-  RemoveTrafficRules (switchDeviceHw, teid);
-  RemoveTrafficRules (switchDeviceUl, teid);
-  RemoveTrafficRules (switchDeviceDl, teid);
-
   m_releaseTrace (teid);
+  auto it = m_preempted.find (teid);
+  if (it != m_preempted.end ())
+    {
+      it->second.Cancel ();
+      m_preempted.erase (it);
+    }
+
+  // Os recursos liberados só estão disponíveis após a remoção das regras no
+  // switch. A barreira desta rajada processa as requisições em espera.
+  // Um tráfego não encontrado (liberação repetida) não tem remoções a
+  // contabilizar.
+  BearerInfo *bearer = m_bearers.Find (teid);
+  if (bearer)
+    {
+      m_ruleBatches [bearer->switchDevice->GetDatapathId ()].freed = true;
+      uint32_t deletes = RemoveBearer (teid);
+      m_deleteTrace (teid, deletes, 4 - deletes);
+    }
   return true;
 }
 
 
 void
 CustomController::NotifyHwSwitch (Ptr<OFSwitch13Device> switchDevice,
-                                  uint32_t ulPort, uint32_t dlPort)
+                                  uint32_t ulPort, uint32_t dlPort,
+                                  uint32_t exactTable)
 {
-  NS_LOG_FUNCTION (this << switchDevice << ulPort << dlPort);
+  NS_LOG_FUNCTION (this << switchDevice << ulPort << dlPort << exactTable);
 
   // Salvando switch e número de portas.
   switchDeviceHw = switchDevice;
   hw2dlPort = dlPort;
   hw2ulPort = ulPort;
 
+  // Com o pipeline dividido, a tabela 0 de correspondência exata fica com as
+  // regras dos tráfegos e a tabela 1 (TCAM) com as regras com curingas.
+  m_hwAggTable = exactTable ? 1 : 0;
+  NS_ASSERT_MSG (!exactTable || switchDevice->GetFlowTableSize (0) == exactTable,
+                 "HW exact-match table size mismatch.");
+
+  // Monitorando a carga do switch para o rebalanceamento por evento.
+  switchDevice->TraceConnect (
+    "DatapathTimeout", "Hw",
+    MakeCallback (&CustomController::NotifyDatapathTimeout, this));
+  switchDevice->TraceConnect (
+    "OverloadDrop", "Hw",
+    MakeCallback (&CustomController::NotifyOverloadDrop, this));
+
   // Neste switch estamos configurando dois grupos:
   // Grupo 1, usado para enviar pacotes na direção de uplink.
   // Grupo 2, usado para enviar pacotes na direção de downlink.
-  std::ostringstream cmd1, cmd2;
-  cmd1 << "group-mod cmd=add,type=ind,group=1"
-       << " weight=0,port=any,group=any"
-       << " output=" << hw2dlPort;
+  GroupModBuilder group1 (OFPGC_ADD, OFPGT_INDIRECT, 1);
+  group1.Output (hw2dlPort);
 
-  cmd2 << "group-mod cmd=add,type=ind,group=2"
-       << " weight=0,port=any,group=any"
-       << " output=" << hw2ulPort;
+  GroupModBuilder group2 (OFPGC_ADD, OFPGT_INDIRECT, 2);
+  group2.Output (hw2ulPort);
 
-  DpctlSchedule (switchDeviceHw->GetDatapathId (), cmd1.str ());
-  DpctlSchedule (switchDeviceHw->GetDatapathId (), cmd2.str ());
+  SendRule (switchDeviceHw, group1.Release ());
+  SendRule (switchDeviceHw, group2.Release ());
+  InstallMissRule (switchDeviceHw);
 }
 
 void
@@ -189,20 +664,26 @@ CustomController::NotifySwSwitch (Ptr<OFSwitch13Device> switchDevice,
   sw2dlPort = dlPort;
   sw2ulPort = ulPort;
 
+  // Monitorando a carga do switch para o rebalanceamento por evento.
+  switchDevice->TraceConnect (
+    "DatapathTimeout", "Sw",
+    MakeCallback (&CustomController::NotifyDatapathTimeout, this));
+  switchDevice->TraceConnect (
+    "OverloadDrop", "Sw",
+    MakeCallback (&CustomController::NotifyOverloadDrop, this));
+
   // Neste switch estamos configurando dois grupos:
   // Grupo 1, usado para enviar pacotes na direção de uplink.
   // Grupo 2, usado para enviar pacotes na direção de downlink.
-  std::ostringstream cmd1, cmd2;
-  cmd1 << "group-mod cmd=add,type=ind,group=1"
-       << " weight=0,port=any,group=any"
-       << " output=" << sw2dlPort;
+  GroupModBuilder group1 (OFPGC_ADD, OFPGT_INDIRECT, 1);
+  group1.Output (sw2dlPort);
 
-  cmd2 << "group-mod cmd=add,type=ind,group=2"
-       << " weight=0,port=any,group=any"
-       << " output=" << sw2ulPort;
+  GroupModBuilder group2 (OFPGC_ADD, OFPGT_INDIRECT, 2);
+  group2.Output (sw2ulPort);
 
-  DpctlSchedule (switchDeviceSw->GetDatapathId (), cmd1.str ());
-  DpctlSchedule (switchDeviceSw->GetDatapathId (), cmd2.str ());
+  SendRule (switchDeviceSw, group1.Release ());
+  SendRule (switchDeviceSw, group2.Release ());
+  InstallMissRule (switchDeviceSw);
 }
 
 void
@@ -227,22 +708,19 @@ CustomController::NotifyUlSwitch (Ptr<OFSwitch13Device> switchDevice,
   // parâmetro nesta função então é tráfego de downlink, senão é tráfego de
   // downlink. Usamos prioridade maior para as portas específicas de downlink,
   // e deixamos o uplink com prioridade menor.
-  std::ostringstream cmdDl1, cmdDl2;
-  cmdDl1 << "flow-mod cmd=add,prio=64,table=0"
-         << " eth_type=0x800,in_port=" << hwPort
-         << " goto:2";
+  FlowModBuilder ruleDl1 (OFPFC_ADD, 0, 64);
+  ruleDl1.MatchEthType (0x800).MatchInPort (hwPort).GotoTable (2);
 
-  cmdDl2 << "flow-mod cmd=add,prio=64,table=0"
-         << " eth_type=0x800,in_port=" << swPort
-         << " goto:2";
+  FlowModBuilder ruleDl2 (OFPFC_ADD, 0, 64);
+  ruleDl2.MatchEthType (0x800).MatchInPort (swPort).GotoTable (2);
 
-  std::ostringstream cmdUl;
-  cmdUl << "flow-mod cmd=add,prio=32,table=0"
-        << " eth_type=0x800 goto:1";
+  FlowModBuilder ruleUl (OFPFC_ADD, 0, 32);
+  ruleUl.MatchEthType (0x800).GotoTable (1);
 
-  DpctlSchedule (switchDeviceUl->GetDatapathId (), cmdDl1.str ());
-  DpctlSchedule (switchDeviceUl->GetDatapathId (), cmdDl2.str ());
-  DpctlSchedule (switchDeviceUl->GetDatapathId (), cmdUl.str ());
+  SendRule (switchDeviceUl, ruleDl1.Release ());
+  SendRule (switchDeviceUl, ruleDl2.Release ());
+  SendRule (switchDeviceUl, ruleUl.Release ());
+  InstallQueueRules (switchDeviceUl, hwPort, swPort);
 
   // Tabela 1: Faz o mapeamento de portas para o tráfego de uplink, decidindo
   // por encaminhar o pacote para o switch HW ou SW. Nesta tabela que este
@@ -279,22 +757,19 @@ CustomController::NotifyDlSwitch (Ptr<OFSwitch13Device> switchDevice,
   // parâmetro nesta função então é tráfego de uplink, senão é tráfego de
   // downlink. Usamos prioridade maior para as portas específicas de uplink, e
   // deixamos o downlink com prioridade menor.
-  std::ostringstream cmdUl1, cmdUl2;
-  cmdUl1 << "flow-mod cmd=add,prio=64,table=0"
-         << " eth_type=0x800,in_port=" << hwPort
-         << " goto:2";
+  FlowModBuilder ruleUl1 (OFPFC_ADD, 0, 64);
+  ruleUl1.MatchEthType (0x800).MatchInPort (hwPort).GotoTable (2);
 
-  cmdUl2 << "flow-mod cmd=add,prio=64,table=0"
-         << " eth_type=0x800,in_port=" << swPort
-         << " goto:2";
+  FlowModBuilder ruleUl2 (OFPFC_ADD, 0, 64);
+  ruleUl2.MatchEthType (0x800).MatchInPort (swPort).GotoTable (2);
 
-  std::ostringstream cmdDl;
-  cmdDl << "flow-mod cmd=add,prio=32,table=0"
-        << " eth_type=0x800 goto:1";
+  FlowModBuilder ruleDl (OFPFC_ADD, 0, 32);
+  ruleDl.MatchEthType (0x800).GotoTable (1);
 
-  DpctlSchedule (switchDeviceDl->GetDatapathId (), cmdUl1.str ());
-  DpctlSchedule (switchDeviceDl->GetDatapathId (), cmdUl2.str ());
-  DpctlSchedule (switchDeviceDl->GetDatapathId (), cmdDl.str ());
+  SendRule (switchDeviceDl, ruleUl1.Release ());
+  SendRule (switchDeviceDl, ruleUl2.Release ());
+  SendRule (switchDeviceDl, ruleDl.Release ());
+  InstallQueueRules (switchDeviceDl, hwPort, swPort);
 
   // Tabela 1: Faz o mapeamento de portas para o tráfego de downlink, decidindo
   // por encaminhar o pacote para o switch HW ou SW. Nesta tabela que este
@@ -310,29 +785,74 @@ CustomController::NotifyDlSwitch (Ptr<OFSwitch13Device> switchDevice,
 }
 
 void
-CustomController::NotifyDl2Sv (uint32_t portNo, Ipv4Address ipAddr)
+CustomController::NotifyDl2Sv (uint32_t portNo, Ipv4Address ipAddr,
+                               Ipv4Mask ipMask)
 {
-  NS_LOG_FUNCTION (this << portNo << ipAddr);
+  NS_LOG_FUNCTION (this << portNo << ipAddr << ipMask);
 
   // Inserindo na tabela 2 a regra que mapeia IP de destino na porta de saída.
-  std::ostringstream cmd;
-  cmd << "flow-mod cmd=add,prio=64,table=2"
-      << " eth_type=0x800,ip_dst=" << ipAddr
-      << " apply:output=" << portNo;
-  DpctlSchedule (switchDeviceDl->GetDatapathId (), cmd.str ());
+  // Os endereços adicionais do servidor são cobertos por uma regra de prefixo.
+  FlowModBuilder rule (OFPFC_ADD, 2, 64);
+  rule.MatchEthType (0x800).MatchIpv4Dst (ipAddr, ipMask).ApplyOutput (portNo);
+  SendRule (switchDeviceDl, rule.Release ());
 }
 
 void
-CustomController::NotifyUl2Cl (uint32_t portNo, Ipv4Address ipAddr)
+CustomController::NotifyUl2Cl (uint32_t portNo, Ipv4Address ipAddr,
+                               Ipv4Mask ipMask)
 {
-  NS_LOG_FUNCTION (this << portNo << ipAddr);
+  NS_LOG_FUNCTION (this << portNo << ipAddr << ipMask);
 
   // Inserindo na tabela 2 a regra que mapeia IP de destino na porta de saída.
-  std::ostringstream cmd;
-  cmd << "flow-mod cmd=add,prio=64,table=2"
-      << " eth_type=0x800,ip_dst=" << ipAddr
-      << " apply:output=" << portNo;
-  DpctlSchedule (switchDeviceUl->GetDatapathId (), cmd.str ());
+  // Com clientes agrupados por porta de acesso, a regra é por prefixo e a
+  // tabela cresce com o número de portas, não com o número de clientes.
+  FlowModBuilder rule (OFPFC_ADD, 2, 64);
+  rule.MatchEthType (0x800).MatchIpv4Dst (ipAddr, ipMask).ApplyOutput (portNo);
+  SendRule (switchDeviceUl, rule.Release ());
+}
+
+void
+CustomController::NotifyAccessSwitch (Ptr<OFSwitch13Device> switchDevice,
+                                      uint32_t ulPort, uint32_t acPort,
+                                      Ipv4Address ipAddr, Ipv4Mask ipMask)
+{
+  NS_LOG_FUNCTION (this << switchDevice << ulPort << acPort << ipAddr);
+
+  // O switch de acesso tem 2 tabelas:
+  //
+  // Tabela 0: Identifica a direção do tráfego pela porta de entrada. Pacotes
+  // vindos do switch UL são de downlink e seguem para a tabela 1. Os demais
+  // são de uplink e vão direto para o switch UL.
+  FlowModBuilder ruleDl (OFPFC_ADD, 0, 64);
+  ruleDl.MatchEthType (0x800).MatchInPort (ulPort).GotoTable (1);
+
+  FlowModBuilder ruleUl (OFPFC_ADD, 0, 32);
+  ruleUl.MatchEthType (0x800).ApplyOutput (ulPort);
+
+  SendRule (switchDevice, ruleDl.Release ());
+  SendRule (switchDevice, ruleUl.Release ());
+
+  // Tabela 1: Faz o mapeamento de portas para o tráfego de downlink de acordo
+  // com o IP do cliente.
+  //
+  // As regras serão instaladas aqui na função NotifyAc2Cl ()
+
+  // No switch UL, uma única regra por prefixo cobre todos os clientes deste
+  // switch de acesso.
+  NotifyUl2Cl (acPort, ipAddr, ipMask);
+}
+
+void
+CustomController::NotifyAc2Cl (Ptr<OFSwitch13Device> switchDevice,
+                               uint32_t portNo, Ipv4Address ipAddr,
+                               Ipv4Mask ipMask)
+{
+  NS_LOG_FUNCTION (this << switchDevice << portNo << ipAddr << ipMask);
+
+  // Inserindo na tabela 1 a regra que mapeia IP de destino na porta de saída.
+  FlowModBuilder rule (OFPFC_ADD, 1, 64);
+  rule.MatchEthType (0x800).MatchIpv4Dst (ipAddr, ipMask).ApplyOutput (portNo);
+  SendRule (switchDevice, rule.Release ());
 }
 
 void
@@ -360,7 +880,36 @@ CustomController::DoDispose ()
   switchDeviceDl = 0;
   switchDeviceHw = 0;
   switchDeviceSw = 0;
-  m_teidAddr.clear ();
+  m_bearers.Clear ();
+  m_overloads.clear ();
+  m_groups.clear ();
+  m_reserved.clear ();
+  m_loadEst.clear ();
+  m_classHw.clear ();
+  m_hwQuota.clear ();
+  m_hwClassBearers.clear ();
+  m_queues.clear ();
+  m_migrations.clear ();
+  m_pending.clear ();
+  for (auto &it : m_preempted)
+    {
+      it.second.Cancel ();
+    }
+  m_preempted.clear ();
+  m_barriers.clear ();
+  m_setups.clear ();
+  m_releases.clear ();
+  m_meters.clear ();
+  m_rebalEvent.Cancel ();
+  for (auto &it : m_ruleBatches)
+    {
+      it.second.flushEvent.Cancel ();
+      for (auto msg : it.second.msgs)
+        {
+          ofl_msg_free (msg, 0);
+        }
+    }
+  m_ruleBatches.clear ();
   OFSwitch13Controller::DoDispose ();
 }
 
@@ -369,8 +918,42 @@ CustomController::NotifyConstructionCompleted (void)
 {
   NS_LOG_FUNCTION (this);
 
-  // Escalona a primeira operação de timeout para o controlador.
+  // Escalona a primeira operação de timeout para o controlador. A
+  // amostragem de carga só alimenta os estimadores suavizados, e não é
+  // necessária na leitura instantânea.
   Simulator::Schedule (m_timeout, &CustomController::ControllerTimeout, this);
+  if (m_loadView != LoadEstimator::INSTANT)
+    {
+      Simulator::Schedule (m_loadSampling,
+                           &CustomController::SampleSwitchLoad, this);
+    }
+
+  // Interpretando as tabelas da alocação por classe de tráfego.
+  for (auto const &entry : ParseClassTable (m_classPref))
+    {
+      NS_ABORT_MSG_IF (entry.second != "Hw" && entry.second != "Sw",
+                       "Invalid switch " << entry.second << " for class " <<
+                       TrafficClassStr (entry.first));
+      m_classHw [entry.first] = entry.second == "Hw";
+    }
+  for (auto const &entry : ParseClassTable (m_classQuota))
+    {
+      m_hwQuota [entry.first] = std::stod (entry.second);
+    }
+  TypeId::AttributeInformation info;
+  TypeId::LookupByName ("ns3::OFSwitch13Queue")
+  .LookupAttributeByName ("NumQueues", &info);
+  uint32_t numQueues = DynamicCast<const UintegerValue> (
+      info.initialValue)->Get ();
+  for (auto const &entry : ParseClassTable (m_classQueue))
+    {
+      uint32_t queue = std::stoul (entry.second);
+      NS_ABORT_MSG_IF (queue >= numQueues,
+                       "Invalid queue " << queue << " for class " <<
+                       TrafficClassStr (entry.first) << " (only " <<
+                       numQueues << " queues per port)");
+      m_queues [entry.first] = queue;
+    }
 
   OFSwitch13Controller::NotifyConstructionCompleted ();
 }
@@ -381,6 +964,211 @@ CustomController::HandshakeSuccessful (Ptr<const RemoteSwitch> swtch)
   NS_LOG_FUNCTION (this << swtch);
 
   OFSwitch13Controller::HandshakeSuccessful (swtch);
+
+  // Enviando as mensagens que aguardavam a conexão com este switch.
+  uint64_t dpId = swtch->GetDpId ();
+  m_connected.insert (dpId);
+  FlushRules (dpId);
+
+  // O micro-benchmark das regras usa o switch UL, que tem espaço de sobra
+  // na tabela.
+  if (m_ruleBench && dpId == switchDeviceUl->GetDatapathId ())
+    {
+      RunRuleBenchmark (swtch);
+    }
+}
+
+void
+CustomController::RunRuleBenchmark (Ptr<const RemoteSwitch> swtch)
+{
+  NS_LOG_FUNCTION (this << swtch);
+
+  // Cada tráfego fictício tem as regras de UL e DL, como em
+  // InstallTrafficRules, na tabela 2 com prioridade mínima e endereços fora
+  // da rede dos clientes. O cookie próprio, acima dos TEIDs, permite
+  // remover todas as regras ao final. Os dois caminhos usam faixas de
+  // endereços disjuntas, para que ambos meçam inserções de novas entradas e
+  // não a substituição das entradas do outro caminho.
+  uint64_t dpId = swtch->GetDpId ();
+  uint64_t cookie = UINT64_C (0xBE) << 32;
+  uint32_t baseAddr = Ipv4Address ("192.168.0.0").Get ();
+  uint16_t port = 10000;
+
+  // Caminho antigo: comandos dpctl em texto, interpretados pela oflib.
+  auto start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < m_ruleBench; i++)
+    {
+      Ipv4Address ipAddr (baseAddr + i);
+      std::ostringstream cmdUl, cmdDl;
+      cmdUl << "flow-mod cmd=add,prio=1,table=2,cookie=0x" << std::hex
+            << (cookie | i) << std::dec << " eth_type=0x800,ip_src=" << ipAddr
+            << ",ip_proto=17,udp_dst=" << port << " write:output=" << ul2hwPort;
+      cmdDl << "flow-mod cmd=add,prio=1,table=2,cookie=0x" << std::hex
+            << (cookie | i) << std::dec << " eth_type=0x800,ip_dst=" << ipAddr
+            << ",ip_proto=17,udp_src=" << port << " write:output=" << ul2hwPort;
+      DpctlExecute (dpId, cmdUl.str ());
+      DpctlExecute (dpId, cmdDl.str ());
+    }
+  std::chrono::duration<double> dpctlTime =
+    std::chrono::steady_clock::now () - start;
+
+  // Caminho novo: mensagens binárias montadas pelos builders.
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t i = m_ruleBench; i < 2 * m_ruleBench; i++)
+    {
+      Ipv4Address ipAddr (baseAddr + i);
+      FlowModBuilder ruleUl (OFPFC_ADD, 2, 1);
+      ruleUl.SetCookie (cookie | i).MatchEthType (0x800).MatchIpv4Src (ipAddr)
+      .MatchIpProto (17).MatchUdpDst (port).WriteOutput (ul2hwPort);
+
+      FlowModBuilder ruleDl (OFPFC_ADD, 2, 1);
+      ruleDl.SetCookie (cookie | i).MatchEthType (0x800).MatchIpv4Dst (ipAddr)
+      .MatchIpProto (17).MatchUdpSrc (port).WriteOutput (ul2hwPort);
+
+      struct ofl_msg_header *msgUl = ruleUl.Release ();
+      struct ofl_msg_header *msgDl = ruleDl.Release ();
+      SendToSwitch (swtch, msgUl);
+      SendToSwitch (swtch, msgDl);
+      ofl_msg_free (msgUl, 0);
+      ofl_msg_free (msgDl, 0);
+    }
+  std::chrono::duration<double> binaryTime =
+    std::chrono::steady_clock::now () - start;
+
+  // Removendo as regras do benchmark.
+  FlowModBuilder rule (OFPFC_DELETE, OFPTT_ALL);
+  rule.SetCookie (cookie, UINT64_C (0xFFFFFFFF00000000));
+  SendRule (switchDeviceUl, rule.Release ());
+
+  uint32_t rules = 2 * m_ruleBench;
+  NS_LOG_INFO ("Rule benchmark with " << rules << " rules: dpctl " <<
+               dpctlTime.count () << "s, binary " << binaryTime.count () << "s");
+  m_benchTrace (rules, rules / dpctlTime.count (),
+                rules / binaryTime.count ());
+}
+
+ofl_err
+CustomController::HandleBarrierReply (
+  struct ofl_msg_header *msg, Ptr<const RemoteSwitch> swtch,
+  uint32_t xid)
+{
+  NS_LOG_FUNCTION (this << swtch << xid);
+
+  // Avançando as migrações que aguardavam esta confirmação.
+  auto it = m_barriers.find (std::make_pair (swtch->GetDpId (), xid));
+  if (it != m_barriers.end ())
+    {
+      std::vector<uint32_t> waiting;
+      waiting.swap (it->second);
+      m_barriers.erase (it);
+      for (auto migration : waiting)
+        {
+          AdvanceMigration (migration);
+        }
+    }
+
+  // Medindo o tempo de instalação das regras reativas desde o packet-in.
+  auto st = m_setups.find (std::make_pair (swtch->GetDpId (), xid));
+  if (st != m_setups.end ())
+    {
+      for (auto const &setup : st->second)
+        {
+          m_setupTrace (setup.first, swtch->GetDpId (),
+                        Simulator::Now () - setup.second);
+        }
+      m_setups.erase (st);
+    }
+
+  // As remoções confirmadas das liberações podem atender as requisições em
+  // espera. As demais barreiras não liberam recursos.
+  if (m_releases.erase (std::make_pair (swtch->GetDpId (), xid))
+      && !m_pending.empty ())
+    {
+      ProcessPendingRequests ();
+    }
+
+  return OFSwitch13Controller::HandleBarrierReply (msg, swtch, xid);
+}
+
+ofl_err
+CustomController::HandlePacketIn (
+  struct ofl_msg_packet_in *msg, Ptr<const RemoteSwitch> swtch,
+  uint32_t xid)
+{
+  NS_LOG_FUNCTION (this << swtch << xid);
+
+  // Apenas os switches HW e SW enviam pacotes ao controlador.
+  uint64_t dpId = swtch->GetDpId ();
+  Ptr<OFSwitch13Device> switchDevice;
+  if (dpId == switchDeviceHw->GetDatapathId ())
+    {
+      switchDevice = switchDeviceHw;
+    }
+  else if (dpId == switchDeviceSw->GetDatapathId ())
+    {
+      switchDevice = switchDeviceSw;
+    }
+  else
+    {
+      return OFSwitch13Controller::HandlePacketIn (msg, swtch, xid);
+    }
+
+  // A direção do pacote é identificada pela porta de entrada no switch que
+  // enviou o packet-in: pacotes vindos da porta para o switch UL são de
+  // uplink. A direção define o grupo de saída: 1 para uplink e 2 para
+  // downlink.
+  uint32_t inPort = 0;
+  struct ofl_match_tlv *tlv =
+    oxm_match_lookup (OXM_OF_IN_PORT, (struct ofl_match*)msg->match);
+  NS_ASSERT_MSG (tlv, "Packet-in message without input port.");
+  memcpy (&inPort, tlv->value, OXM_LENGTH (OXM_OF_IN_PORT));
+  uint32_t ulPort = switchDevice == switchDeviceHw ? hw2ulPort : sw2ulPort;
+  bool uplink = inPort == ulPort;
+  uint32_t group = uplink ? 1 : 2;
+
+  BearerInfo *bearer = FindPacketBearer (msg, uplink);
+  if (bearer && bearer->ruleWait && bearer->switchDevice == switchDevice)
+    {
+      // Primeiro packet-in do tráfego: as regras são instaladas e a regra
+      // desta direção libera o pacote guardado no buffer do switch.
+      uint32_t teid = bearer->teid;
+      uint32_t bufferUl = uplink ? msg->buffer_id : OFP_NO_BUFFER;
+      uint32_t bufferDl = uplink ? OFP_NO_BUFFER : msg->buffer_id;
+      InstallTrafficRules (switchDevice, teid, bufferUl, bufferDl);
+      m_packetInTrace (dpId, teid, false);
+
+      // As regras reativas são enviadas sem aguardar a janela de agrupamento.
+      RuleBatch &batch = m_ruleBatches [dpId];
+      batch.setups.push_back (std::make_pair (teid, Simulator::Now ()));
+      FlushRules (dpId);
+
+      // Sem buffer no switch, o pacote volta junto com a mensagem packet-out.
+      if (msg->buffer_id == OFP_NO_BUFFER)
+        {
+          PacketOutBuilder packet (msg, inPort);
+          packet.Group (group);
+          struct ofl_msg_header *out = packet.Release ();
+          SendToSwitch (swtch, out);
+          ofl_msg_free (out, 0);
+        }
+    }
+  else
+    {
+      // Packet-ins duplicados, de tráfegos com regras já enviadas ou em
+      // migração, seguem pelo grupo de saída. Pacotes de tráfegos
+      // desconhecidos são descartados, liberando o buffer no switch.
+      PacketOutBuilder packet (msg, inPort);
+      if (bearer)
+        {
+          packet.Group (group);
+        }
+      struct ofl_msg_header *out = packet.Release ();
+      SendToSwitch (swtch, out);
+      ofl_msg_free (out, 0);
+      m_packetInTrace (dpId, bearer ? bearer->teid : 0, bearer != 0);
+    }
+
+  return OFSwitch13Controller::HandlePacketIn (msg, swtch, xid);
 }
 
 void
@@ -394,32 +1182,34 @@ CustomController::ConfigureByIp ()
 
   // Pacotes originados nos clientes, que estão entrando através do switch UL.
   {
-    std::ostringstream cmdHw, cmdSw;
-    cmdHw << "flow-mod cmd=add,prio=64,table=1"
-          << " eth_type=0x800,ip_src=0.0.0.0/0.0.0.1"
-          << " apply:output=" << ul2hwPort;
-
-    cmdSw << "flow-mod cmd=add,prio=64,table=1"
-          << " eth_type=0x800,ip_src=0.0.0.1/0.0.0.1"
-          << " apply:output=" << ul2swPort;
-
-    DpctlSchedule (switchDeviceUl->GetDatapathId (), cmdHw.str ());
-    DpctlSchedule (switchDeviceUl->GetDatapathId (), cmdSw.str ());
+    FlowModBuilder ruleHw (OFPFC_ADD, 1, 64);
+    ruleHw.MatchEthType (0x800)
+    .MatchIpv4Src (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.1"))
+    .ApplyOutput (ul2hwPort);
+
+    FlowModBuilder ruleSw (OFPFC_ADD, 1, 64);
+    ruleSw.MatchEthType (0x800)
+    .MatchIpv4Src (Ipv4Address ("0.0.0.1"), Ipv4Mask ("0.0.0.1"))
+    .ApplyOutput (ul2swPort);
+
+    SendRule (switchDeviceUl, ruleHw.Release ());
+    SendRule (switchDeviceUl, ruleSw.Release ());
   }
 
   // Pacotes originados no servidor, que estão entrando através do switch DL.
   {
-    std::ostringstream cmdHw, cmdSw;
-    cmdHw << "flow-mod cmd=add,prio=64,table=1"
-          << " eth_type=0x800,ip_dst=0.0.0.0/0.0.0.1"
-          << " apply:output=" << dl2hwPort;
-
-    cmdSw << "flow-mod cmd=add,prio=64,table=1"
-          << " eth_type=0x800,ip_dst=0.0.0.1/0.0.0.1"
-          << " apply:output=" << dl2swPort;
-
-    DpctlSchedule (switchDeviceDl->GetDatapathId (), cmdHw.str ());
-    DpctlSchedule (switchDeviceDl->GetDatapathId (), cmdSw.str ());
+    FlowModBuilder ruleHw (OFPFC_ADD, 1, 64);
+    ruleHw.MatchEthType (0x800)
+    .MatchIpv4Dst (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.1"))
+    .ApplyOutput (dl2hwPort);
+
+    FlowModBuilder ruleSw (OFPFC_ADD, 1, 64);
+    ruleSw.MatchEthType (0x800)
+    .MatchIpv4Dst (Ipv4Address ("0.0.0.1"), Ipv4Mask ("0.0.0.1"))
+    .ApplyOutput (dl2swPort);
+
+    SendRule (switchDeviceDl, ruleHw.Release ());
+    SendRule (switchDeviceDl, ruleSw.Release ());
   }
 }
 
@@ -432,64 +1222,70 @@ CustomController::ConfigureByQos ()
 
   // Pacotes originados nos clientes, que estão entrando através do switch UL.
   {
-    std::ostringstream cmdSw;
-    cmdSw << "flow-mod cmd=add,prio=64,table=1"
-          << " eth_type=0x800"
-          << " apply:output=" << ul2swPort;
+    FlowModBuilder ruleSw (OFPFC_ADD, 1, 64);
+    ruleSw.MatchEthType (0x800).ApplyOutput (ul2swPort);
 
-    DpctlSchedule (switchDeviceUl->GetDatapathId (), cmdSw.str ());
+    SendRule (switchDeviceUl, ruleSw.Release ());
   }
 
   // Pacotes originados no servidor, que estão entrando através do switch DL.
   {
-    std::ostringstream cmdSw;
-    cmdSw << "flow-mod cmd=add,prio=64,table=1"
-          << " eth_type=0x800"
-          << " apply:output=" << dl2swPort;
+    FlowModBuilder ruleSw (OFPFC_ADD, 1, 64);
+    ruleSw.MatchEthType (0x800).ApplyOutput (dl2swPort);
 
-    DpctlSchedule (switchDeviceDl->GetDatapathId (), cmdSw.str ());
+    SendRule (switchDeviceDl, ruleSw.Release ());
   }
 }
 
 void
 CustomController::InstallTrafficRules (Ptr<OFSwitch13Device> switchDevice,
-                                       uint32_t teid)
+                                       uint32_t teid, uint32_t bufferUl,
+                                       uint32_t bufferDl)
 {
-  NS_LOG_FUNCTION (this << switchDevice << teid);
+  NS_LOG_FUNCTION (this << switchDevice << teid << bufferUl << bufferDl);
 
-  // Recuperando o IP do cliente.
-  Ipv4Address ipv4addr = m_teidAddr [teid];
-
-  // Estamos considerando os valores manualmente adicionados ao TEID para
-  // identificar a aplicação. As 4 primeiras são TCP, e as demais UDP.
-  bool tcpApp = (teid & 0xF) <= 3;
-  uint16_t port = teid + 10000;
+  BearerInfo *bearer = m_bearers.Find (teid);
+  NS_ASSERT_MSG (bearer, "No metadata for traffic " << teid);
 
   // Instalar as regras identificando o trafego pelo teid no cookie.
-  std::ostringstream cmdUl, cmdDl;
-  cmdUl << "flow-mod cmd=add,prio=64,table=0,cookie=" << GetUint32Hex (teid)
-        << " eth_type=0x800,ip_src=" << ipv4addr;
-  cmdDl << "flow-mod cmd=add,prio=64,table=0,cookie=" << GetUint32Hex (teid)
-        << " eth_type=0x800,ip_dst=" << ipv4addr;
+  FlowModBuilder ruleUl (OFPFC_ADD, 0, 64);
+  FlowModBuilder ruleDl (OFPFC_ADD, 0, 64);
+  SetTrafficMatch (ruleUl, ruleDl, *bearer);
 
-  if (tcpApp)
+  // O medidor do tráfego, com o teid como identificador, é compartilhado
+  // pelas duas direções e deve existir antes das regras que o usam.
+  if (m_meterPol != CustomController::NO_METER)
     {
-      // Regras específicas para protocolo TCP.
-      cmdUl << ",ip_proto=6,tcp_dst=" << port;
-      cmdDl << ",ip_proto=6,tcp_src=" << port;
+      InstallMeter (switchDevice, *bearer);
+      ruleUl.Meter (teid);
+      ruleDl.Meter (teid);
     }
-  else
+
+  // A fila de saída da classe vale para este switch, e a marcação DSCP
+  // permite que os switches UL e DL selecionem a mesma fila.
+  TrafficClass cls = GetTrafficClass (teid);
+  uint32_t queue = GetClassQueue (cls);
+  if (queue)
     {
-      // Regras específicas para protocolo UDP.
-      cmdUl << ",ip_proto=17,udp_dst=" << port;
-      cmdDl << ",ip_proto=17,udp_src=" << port;
+      ruleUl.WriteQueue (queue).WriteDscp (GetClassDscp (cls));
+      ruleDl.WriteQueue (queue).WriteDscp (GetClassDscp (cls));
     }
 
-  cmdUl << " write:group=1";
-  cmdDl << " write:group=2";
-
-  DpctlExecute (switchDevice->GetDatapathId (), cmdUl.str ());
-  DpctlExecute (switchDevice->GetDatapathId (), cmdDl.str ());
+  ruleUl.WriteGroup (1).SetBufferId (bufferUl);
+  ruleDl.WriteGroup (2).SetBufferId (bufferDl);
+
+  SendRule (switchDevice, ruleUl.Release ());
+  SendRule (switchDevice, ruleDl.Release ());
+
+  // Atualizando o índice de tráfegos. As entradas na tabela do switch só
+  // existirão após o processamento das regras, e serão localizadas depois.
+  SetBearerSwitch (*bearer, switchDevice);
+  bearer->ruleWait = false;
+  bearer->installed = Simulator::Now ();
+  bearer->entries = 0;
+  bearer->lastBytes = 0;
+  bearer->lastPkts = 0;
+  bearer->lastUpdate = Simulator::Now ();
 }
 
 void
@@ -499,11 +1295,23 @@ CustomController::RemoveTrafficRules (Ptr<OFSwitch13Device> switchDevice,
   NS_LOG_FUNCTION (this << switchDevice << teid);
 
   // Usar o teid como identificador da regra pelo campo cookie.
-  std::ostringstream cmd;
-  cmd << "flow-mod cmd=del,cookie=" << GetUint32Hex (teid)
-      << ",cookie_mask=0xFFFFFFFFFFFFFFFF";
+  FlowModBuilder rule (OFPFC_DELETE, OFPTT_ALL);
+  rule.SetCookie (teid);
+
+  SendRule (switchDevice, rule.Release ());
+
+  // Os medidores existem apenas nos switches HW e SW.
+  if (switchDevice == switchDeviceHw || switchDevice == switchDeviceSw)
+    {
+      RemoveMeter (switchDevice, teid);
+    }
 
-  DpctlExecute (switchDevice->GetDatapathId (), cmd.str ());
+  // As entradas deste tráfego no switch deixarão de existir.
+  BearerInfo *bearer = m_bearers.Find (teid);
+  if (bearer && bearer->switchDevice == switchDevice)
+    {
+      bearer->entries = 0;
+    }
 }
 
 void
@@ -513,12 +1321,11 @@ CustomController::MoveTrafficRules (Ptr<OFSwitch13Device> srcSwitchDevice,
 {
   NS_LOG_FUNCTION (this << srcSwitchDevice << dstSwitchDevice << teid);
 
-  // Instala regras no switch de destino e escalona remoção no switch de origem.
+  // Instala regras no switch de destino. O redirecionamento nos switches UL e
+  // DL e a remoção no switch de origem ocorrem após as confirmações.
   InstallTrafficRules (dstSwitchDevice, teid);
-  Simulator::Schedule (MilliSeconds (500), &CustomController::UpdateDlUlRules,
-                       this, teid);
-  Simulator::Schedule (Seconds (1), &CustomController::RemoveTrafficRules,
-                       this, srcSwitchDevice, teid);
+  m_bearers.Find (teid)->lastMove = Simulator::Now ();
+  StartMigration (teid, false, srcSwitchDevice, dstSwitchDevice);
 }
 
 void
@@ -526,134 +1333,1536 @@ CustomController::UpdateDlUlRules (uint32_t teid)
 {
   NS_LOG_FUNCTION (this << teid);
 
-  // Instalar regras com maior prioridade nos switches UL e DL.
-
-  // Recuperando o IP do cliente.
-  Ipv4Address ipv4addr = m_teidAddr [teid];
+  // O tráfego pode ter sido liberado antes desta atualização.
+  BearerInfo *bearer = m_bearers.Find (teid);
+  if (!bearer)
+    {
+      return;
+    }
 
-  // Estamos considerando os valores manualmente adicionados ao TEID para
-  // identificar a aplicação. As 4 primeiras são TCP, e as demais UDP.
-  bool tcpApp = (teid & 0xF) <= 3;
-  uint16_t port = teid + 10000;
+  // Instalar regras com maior prioridade nos switches UL e DL, direcionando o
+  // tráfego para o switch onde ele está agora. Uma nova regra com a mesma
+  // prioridade e match substitui a anterior.
+  bool toHw = bearer->switchDevice == switchDeviceHw;
 
   // Instalar as regras identificando o trafego pelo teid no cookie.
-  std::ostringstream cmdUl, cmdDl;
-  cmdUl << "flow-mod cmd=add,prio=128,table=1,cookie=" << GetUint32Hex (teid)
-        << " eth_type=0x800,ip_src=" << ipv4addr;
-  cmdDl << "flow-mod cmd=add,prio=128,table=1,cookie=" << GetUint32Hex (teid)
-        << " eth_type=0x800,ip_dst=" << ipv4addr;
+  FlowModBuilder ruleUl (OFPFC_ADD, 1, 128);
+  FlowModBuilder ruleDl (OFPFC_ADD, 1, 128);
+  SetTrafficMatch (ruleUl, ruleDl, *bearer);
 
-  if (tcpApp)
+  uint32_t queue = GetClassQueue (GetTrafficClass (teid));
+  if (queue)
     {
-      // Regras específicas para protocolo TCP.
-      cmdUl << ",ip_proto=6,tcp_dst=" << port;
-      cmdDl << ",ip_proto=6,tcp_src=" << port;
+      ruleUl.ApplyQueue (queue);
+      ruleDl.ApplyQueue (queue);
     }
-  else
+
+  ruleUl.ApplyOutput (toHw ? ul2hwPort : ul2swPort);
+  ruleDl.ApplyOutput (toHw ? dl2hwPort : dl2swPort);
+
+  SendRule (switchDeviceUl, ruleUl.Release ());
+  SendRule (switchDeviceDl, ruleDl.Release ());
+  bearer->dlUlRules = true;
+}
+
+CustomController::TrafficClass
+CustomController::GetTrafficClass (uint32_t teid)
+{
+  switch (teid & 0xF)
     {
-      // Regras específicas para protocolo UDP.
-      cmdUl << ",ip_proto=17,udp_dst=" << port;
-      cmdDl << ",ip_proto=17,udp_src=" << port;
+    case 4:   // AutPilot
+    case 5:
+    case 9:   // BikeRace
+    case 10:  // GpsTrack
+      return CustomController::TELEMETRY;
+    case 6:   // GameOpen
+    case 7:   // GameTeam
+    case 8:   // VoipCall
+      return CustomController::REALTIME;
+    case 11:  // LivVideo
+    case 12:
+      return CustomController::STREAMING;
+    default:  // BufVideo e HttpPage
+      return CustomController::ELASTIC;
     }
+}
 
-  cmdUl << " apply:output=" << ul2hwPort;
-  cmdDl << " apply:output=" << dl2hwPort;
-
-  DpctlExecute (switchDeviceUl->GetDatapathId (), cmdUl.str ());
-  DpctlExecute (switchDeviceDl->GetDatapathId (), cmdDl.str ());
+std::string
+CustomController::TrafficClassStr (TrafficClass cls)
+{
+  switch (cls)
+    {
+    case CustomController::ELASTIC:
+      return "Elastic";
+    case CustomController::TELEMETRY:
+      return "Telemetry";
+    case CustomController::REALTIME:
+      return "Realtime";
+    case CustomController::STREAMING:
+      return "Streaming";
+    default:
+      return "-";
+    }
 }
 
-// Declarando tipo de par TEID / vazão.
-typedef std::pair<uint32_t, DataRate> TeidThp_t;
+uint8_t
+CustomController::GetClassDscp (TrafficClass cls)
+{
+  switch (cls)
+    {
+    case CustomController::REALTIME:
+      return Ipv4Header::DSCP_EF;
+    case CustomController::STREAMING:
+      return Ipv4Header::DSCP_AF41;
+    case CustomController::TELEMETRY:
+      return Ipv4Header::DSCP_AF21;
+    default:
+      return Ipv4Header::DSCP_AF11;
+    }
+}
 
-// Declarando tipo de função que recever dois pares TeidThp_t e retorna bool.
-typedef std::function<bool (TeidThp_t, TeidThp_t)> TeidThpComp_t;
+std::map<CustomController::TrafficClass, std::string>
+CustomController::ParseClassTable (const std::string &table)
+{
+  std::map<TrafficClass, std::string> values;
+  std::istringstream stream (table);
+  std::string item;
+  while (std::getline (stream, item, ','))
+    {
+      size_t pos = item.find ('=');
+      NS_ABORT_MSG_IF (pos == std::string::npos,
+                       "Invalid class table entry " << item);
+
+      std::string name = item.substr (0, pos);
+      bool found = false;
+      for (int c = CustomController::ELASTIC;
+           c <= CustomController::STREAMING; c++)
+        {
+          TrafficClass cls = static_cast<TrafficClass> (c);
+          if (name == TrafficClassStr (cls))
+            {
+              values [cls] = item.substr (pos + 1);
+              found = true;
+            }
+        }
+      NS_ABORT_MSG_IF (!found, "Invalid traffic class " << name);
+    }
+  return values;
+}
 
-// Comparador para ordenar o mapa de vazão por tráfego.
-TeidThpComp_t thpComp = [] (TeidThp_t elem1, TeidThp_t elem2)
-  {
-    return elem1.second > elem2.second;
-  };
+uint32_t
+CustomController::GetClassQueue (TrafficClass cls) const
+{
+  auto it = m_queues.find (cls);
+  return it == m_queues.end () ? 0 : it->second;
+}
 
 void
-CustomController::ControllerTimeout ()
+CustomController::InstallQueueRules (Ptr<OFSwitch13Device> switchDevice,
+                                     uint32_t hwPort, uint32_t swPort)
 {
-  NS_LOG_FUNCTION (this);
-
-  // Escalona a próxima operação de timeout para o controlador.
-  Simulator::Schedule (m_timeout, &CustomController::ControllerTimeout, this );
+  NS_LOG_FUNCTION (this << switchDevice << hwPort << swPort);
 
-  // Para o roteamento por IP não há nada a ser feito aqui.
-  if (!m_qosRoute)
+  // Os pacotes vindos dos switches HW e SW foram marcados com o DSCP da
+  // classe. Estas regras têm prioridade maior que as da direção na tabela 0,
+  // e selecionam a fila antes de seguir para a tabela 2. Pacotes sem marca,
+  // ou remarcados pelos medidores, seguem na fila padrão.
+  for (auto const &entry : m_queues)
     {
-      return;
-    }
+      if (!entry.second)
+        {
+          continue;
+        }
 
-  // O roteamento é por QoS. Vamos percorrer a tabela do switch SW e montar uma
-  // lista ordenada dos tráfegos com vazão decrescente para que possamos mover
-  // os tráfegos de maior vazão para o switch de HW sem extrapolar sua
-  // capacidade máxima.
+      for (auto port : {hwPort, swPort})
+        {
+          FlowModBuilder rule (OFPFC_ADD, 0, 96);
+          rule.MatchEthType (0x800).MatchInPort (port)
+          .MatchIpDscp (GetClassDscp (entry.first))
+          .ApplyQueue (entry.second).GotoTable (2);
 
-  struct datapath *datapath = switchDeviceSw->GetDatapathStruct ();
-  struct flow_table *table = datapath->pipeline->tables[0];
-  struct flow_entry *entry;
+          SendRule (switchDevice, rule.Release ());
+        }
+    }
+}
 
-  std::map<uint32_t, DataRate> thpByTeid;
-  bool firstRule = true;
-  double bytes;
+bool
+CustomController::HasHwQuota (TrafficClass cls)
+{
+  NS_LOG_FUNCTION (this << cls);
 
-  // Percorrendo tabela e recuperando informações sobre os tráfegos.
-  LIST_FOR_EACH (entry, struct flow_entry, match_node, &table->match_entries)
-  {
-    struct ofl_flow_stats *stats = entry->stats;
-    Time active = Simulator::Now () - MilliSeconds (entry->created);
+  auto it = m_hwQuota.find (cls);
+  if (it == m_hwQuota.end ())
+    {
+      return true;
+    }
 
-    // Temos sempre duas regras para cada tráfego (uplink e downlink).
-    if (firstRule)
-      {
-        bytes = entry->stats->byte_count;
-        firstRule = false;
-        continue;
-      }
-    bytes += stats->byte_count;
-    firstRule = true;
-
-    // Calculando a vazão total para o tráfego.
-    DataRate throughput (bytes * 8 / active.GetSeconds ());
-    thpByTeid [entry->stats->cookie] = throughput;
-    NS_LOG_DEBUG ("Traffic " << entry->stats->cookie <<
-                  " with throughput " << throughput);
-  }
+  // Cada tráfego no switch HW ocupa duas entradas na tabela 0.
+  uint32_t entries = 2 * (m_hwClassBearers [cls] + 1);
+  return entries <= it->second * switchDeviceHw->GetFlowTableSize (0);
+}
 
-  // Construindo um set com as vazões ordenadas em descrescente.
-  std::set<TeidThp_t, TeidThpComp_t> thpSorted (
-    thpByTeid.begin (), thpByTeid.end (), thpComp);
+void
+CustomController::SetBearerSwitch (BearerInfo &bearer,
+                                   Ptr<OFSwitch13Device> switchDevice)
+{
+  NS_LOG_FUNCTION (this << bearer.teid << switchDevice);
 
-  // Verificando os recursos disponíveis no switch de HW:
-  uint32_t tabHwFree =
-    switchDeviceHw->GetFlowTableSize (0) * m_blockThs -
-    switchDeviceHw->GetFlowTableEntries (0);
-  uint64_t bpsHwFree =
-    switchDeviceHw->GetCpuCapacity ().GetBitRate () * m_blockThs -
-    switchDeviceHw->GetCpuLoad ().GetBitRate ();
-  NS_LOG_DEBUG ("Resources on HW switch: " << tabHwFree <<
-                " table entries and " << bpsHwFree << " CPU bps free.");
+  // Transferindo a reserva de vazão do tráfego para o novo switch e mantendo
+  // a contagem de tráfegos por classe no switch HW.
+  TrafficClass cls = GetTrafficClass (bearer.teid);
+  if (bearer.switchDevice)
+    {
+      m_reserved [bearer.switchDevice->GetDatapathId ()] -= bearer.expected;
+      if (bearer.switchDevice == switchDeviceHw)
+        {
+          m_hwClassBearers [cls]--;
+        }
+    }
+  if (switchDevice)
+    {
+      m_reserved [switchDevice->GetDatapathId ()] += bearer.expected;
+      if (switchDevice == switchDeviceHw)
+        {
+          m_hwClassBearers [cls]++;
+        }
+    }
+  bearer.switchDevice = switchDevice;
+}
+
+bool
+CustomController::HasResources (Ptr<OFSwitch13Device> switchDevice,
+                                uint64_t expected)
+{
+  NS_LOG_FUNCTION (this << switchDevice << expected);
+
+  double entries, bps;
+  GetDeficit (switchDevice, expected, entries, bps);
+  return entries <= 0 && bps <= 0;
+}
+
+void
+CustomController::GetDeficit (Ptr<OFSwitch13Device> switchDevice,
+                              uint64_t expected, double &entries, double &bps)
+{
+  NS_LOG_FUNCTION (this << switchDevice << expected);
+
+  // Verifica os recursos disponíveis no switch (processamento e uso de tabela)
+  // As regras dos tráfegos ocupam apenas a tabela 0. Com o pipeline dividido
+  // no HW, ela é a tabela de correspondência exata, e as regras com curingas
+  // da tabela 1 não disputam entradas com os tráfegos.
+  uint32_t tabSize = switchDevice->GetFlowTableSize (0);
+  uint64_t cpuSize = switchDevice->GetCpuCapacity ().GetBitRate ();
+  double tabUse = switchDevice->GetFlowTableUsage (0);
+  double cpuUse = GetSwitchLoad (switchDevice);
 
-  // Percore a lista de tráfego movendo os primeiros para o switch de HW.
-  for (auto element : thpSorted)
+  // Na admissão preditiva, o uso de cpu considera a vazão esperada de todos
+  // os tráfegos já aceitos no switch e deste novo tráfego, evitando que uma
+  // rajada de requisições seja aceita antes que a carga apareça no switch.
+  if (m_admMode == CustomController::PREDICTIVE)
     {
-      if (tabHwFree < 2 || bpsHwFree < element.second.GetBitRate ())
+      uint64_t reserved = m_reserved [switchDevice->GetDatapathId ()];
+      cpuUse = static_cast<double> (reserved + expected) / cpuSize;
+    }
+
+  // Bloquear o tráfego se a tabela exceder o limite de bloqueio.
+  entries = (tabUse - m_blockThs) * tabSize;
+
+  // Bloquear o tráfego se o uso de cpu exceder o limite de bloqueio e a
+  // política de bloqueio por excesso de carga estiver ativa.
+  bps = m_blockPol ? (cpuUse - m_blockThs) * cpuSize : 0;
+}
+
+bool
+CustomController::PreemptBearers (Ptr<OFSwitch13Device> switchDevice,
+                                  Ptr<SvelteClient> app, uint64_t expected)
+{
+  NS_LOG_FUNCTION (this << switchDevice << app << expected);
+
+  AllocationRetentionPriority arp = app->GetEpsBearer ().arp;
+  if (!m_preemption || !arp.preemptionCapability)
+    {
+      return false;
+    }
+
+  // Candidatos são os tráfegos ativos e vulneráveis no switch com prioridade
+  // menor (nível ARP maior) que a do novo tráfego. Os tráfegos já parando
+  // ou ainda não iniciados não liberam recursos a tempo.
+  std::vector<BearerInfo*> candidates;
+  for (auto &bearer : m_bearers)
+    {
+      AllocationRetentionPriority other = bearer.app->GetEpsBearer ().arp;
+      if (bearer.switchDevice == switchDevice
+          && other.preemptionVulnerability
+          && other.priorityLevel > arp.priorityLevel
+          && bearer.app->IsActive () && !bearer.app->IsForceStop ())
+        {
+          candidates.push_back (&bearer);
+        }
+    }
+
+  // Preemptando primeiro os tráfegos de menor prioridade e, entre eles, os
+  // que liberam mais processamento.
+  bool predictive = m_admMode == CustomController::PREDICTIVE;
+  auto freedBps = [predictive] (const BearerInfo *bearer)
+    {
+      return predictive ? bearer->expected : bearer->rate.GetRate ().GetBitRate ();
+    };
+  std::stable_sort (candidates.begin (), candidates.end (),
+                    [&freedBps] (const BearerInfo *a, const BearerInfo *b)
+    {
+      uint8_t levelA = a->app->GetEpsBearer ().arp.priorityLevel;
+      uint8_t levelB = b->app->GetEpsBearer ().arp.priorityLevel;
+      return levelA != levelB ? levelA > levelB : freedBps (a) > freedBps (b);
+    });
+
+  double entries, bps;
+  GetDeficit (switchDevice, expected, entries, bps);
+  std::vector<Ptr<SvelteClient> > victims;
+  for (auto bearer : candidates)
+    {
+      if (entries <= 0 && bps <= 0)
         {
-          // Parar se não houver mais recursos disponíveis no HW.
           break;
         }
+      victims.push_back (bearer->app);
+      entries -= 2;
+      bps -= freedBps (bearer);
+    }
+  if (entries > 0 || bps > 0)
+    {
+      return false;
+    }
+
+  // Parando as aplicações dos tráfegos preemptados. As regras continuam
+  // instaladas até a liberação reportada pela parada da aplicação, pois as
+  // aplicações TCP só param após receber o objeto em curso.
+  for (auto victim : victims)
+    {
+      uint32_t teid = victim->GetTeid ();
+      NS_LOG_INFO ("Traffic " << teid << " preempted by " << app->GetTeid ());
+      m_preempted [teid] = Simulator::Schedule (
+          m_preemptTimeout, &CustomController::CheckPreempted, this, victim);
+      victim->Preempt ();
+      m_preemptTrace (teid, app->GetTeid ());
+    }
+  return true;
+}
+
+void
+CustomController::CheckPreempted (Ptr<SvelteClient> app)
+{
+  NS_LOG_FUNCTION (this << app);
+
+  // A liberação cancela esta verificação. Uma aplicação ainda ativa aqui
+  // nunca chegou à parada e manteria os recursos reservados.
+  m_preempted.erase (app->GetTeid ());
+  NS_ABORT_MSG_IF (app->IsActive (), "Preempted traffic " << app->GetTeid () <<
+                   " did not stop within " << m_preemptTimeout.GetSeconds () <<
+                   "s.");
+}
+
+uint32_t
+CustomController::RemoveBearer (uint32_t teid)
+{
+  NS_LOG_FUNCTION (this << teid);
+
+  // Removendo as regras apenas dos switches onde elas existem: o switch HW ou
+  // SW que atende o tráfego e, se ele já foi movido, os switches UL e DL. Uma
+  // remoção pendente no switch de origem de uma mudança já está agendada.
+  uint32_t deletes = 0;
+  BearerInfo *bearer = m_bearers.Find (teid);
+  if (bearer)
+    {
+      RemoveTrafficRules (bearer->switchDevice, teid);
+      deletes++;
+      if (bearer->dlUlRules)
+        {
+          RemoveTrafficRules (switchDeviceUl, teid);
+          RemoveTrafficRules (switchDeviceDl, teid);
+          deletes += 2;
+        }
+      SetBearerSwitch (*bearer, 0);
+      m_bearers.Erase (teid);
+    }
+  return deletes;
+}
+
+void
+CustomController::InstallGroupRules (Ptr<OFSwitch13Device> switchDevice,
+                                     const BearerInfo &bearer)
+{
+  NS_LOG_FUNCTION (this << switchDevice << bearer.teid);
+
+  if (m_groups.find (bearer.group) != m_groups.end ())
+    {
+      return;
+    }
+
+  // O grupo começa no switch que recebe o primeiro tráfego do cliente e só é
+  // removido ao final da simulação.
+  bool toHw = switchDevice == switchDeviceHw;
+  GroupInfo &group = m_groups [bearer.group];
+  group.switchDevice = switchDevice;
+  group.lastMove = Time (0);
+
+  // Nos switches UL e DL, um grupo indireto por cliente encaminha os pacotes
+  // para o switch que atende o cliente. Mover o cliente de switch exige
+  // apenas a alteração deste grupo em cada direção.
+  GroupModBuilder groupUl (OFPGC_ADD, OFPGT_INDIRECT, bearer.group);
+  groupUl.Output (toHw ? ul2hwPort : ul2swPort);
+
+  GroupModBuilder groupDl (OFPGC_ADD, OFPGT_INDIRECT, bearer.group);
+  groupDl.Output (toHw ? dl2hwPort : dl2swPort);
+
+  SendRule (switchDeviceUl, groupUl.Release ());
+  SendRule (switchDeviceDl, groupDl.Release ());
+
+  // Na tabela 1, as regras do cliente têm prioridade maior que as regras
+  // padrão instaladas por ConfigureByQos ().
+  FlowModBuilder ruleUl (OFPFC_ADD, 1, 128);
+  ruleUl.MatchEthType (0x800).MatchIpv4Src (bearer.ipAddr)
+  .ApplyGroup (bearer.group);
+
+  FlowModBuilder ruleDl (OFPFC_ADD, 1, 128);
+  ruleDl.MatchEthType (0x800).MatchIpv4Dst (bearer.ipAddr)
+  .ApplyGroup (bearer.group);
+
+  SendRule (switchDeviceUl, ruleUl.Release ());
+  SendRule (switchDeviceDl, ruleDl.Release ());
+}
+
+void
+CustomController::MoveGroupRules (Ptr<OFSwitch13Device> srcSwitchDevice,
+                                  Ptr<OFSwitch13Device> dstSwitchDevice,
+                                  uint32_t group,
+                                  const std::vector<uint32_t> &teids)
+{
+  NS_LOG_FUNCTION (this << srcSwitchDevice << dstSwitchDevice << group);
+
+  // Instala as regras de todos os tráfegos do grupo no switch de destino. A
+  // alteração dos grupos nos switches UL e DL e a única remoção no switch de
+  // origem ocorrem após as confirmações.
+  for (auto teid : teids)
+    {
+      InstallTrafficRules (dstSwitchDevice, teid);
+      m_bearers.Find (teid)->lastMove = Simulator::Now ();
+    }
+
+  GroupInfo &info = m_groups [group];
+  info.switchDevice = dstSwitchDevice;
+  info.lastMove = Simulator::Now ();
+  StartMigration (group, true, srcSwitchDevice, dstSwitchDevice);
+}
+
+void
+CustomController::UpdateGroupRules (uint32_t group)
+{
+  NS_LOG_FUNCTION (this << group);
+
+  // Direcionando o grupo para o switch onde os tráfegos estão agora.
+  bool toHw = m_groups [group].switchDevice == switchDeviceHw;
+
+  GroupModBuilder groupUl (OFPGC_MODIFY, OFPGT_INDIRECT, group);
+  groupUl.Output (toHw ? ul2hwPort : ul2swPort);
+
+  GroupModBuilder groupDl (OFPGC_MODIFY, OFPGT_INDIRECT, group);
+  groupDl.Output (toHw ? dl2hwPort : dl2swPort);
+
+  SendRule (switchDeviceUl, groupUl.Release ());
+  SendRule (switchDeviceDl, groupDl.Release ());
+}
+
+void
+CustomController::RemoveGroupRules (Ptr<OFSwitch13Device> switchDevice,
+                                    uint32_t group)
+{
+  NS_LOG_FUNCTION (this << switchDevice << group);
+
+  // O grupo é o índice do cliente no TEID, então uma única remoção por
+  // cookie com máscara apaga as regras de todos os tráfegos do grupo. Se o
+  // grupo voltou para este switch, suas regras não podem ser removidas.
+  if (m_groups [group].switchDevice == switchDevice)
+    {
+      return;
+    }
+
+  FlowModBuilder rule (OFPFC_DELETE, OFPTT_ALL);
+  rule.SetCookie (group << 4, ~UINT64_C (0xF));
+
+  SendRule (switchDevice, rule.Release ());
+
+  // Os medidores são removidos individualmente.
+  for (auto const &bearer : m_bearers)
+    {
+      if (bearer.group == group)
+        {
+          RemoveMeter (switchDevice, bearer.teid);
+        }
+    }
+}
+
+void
+CustomController::InstallMissRule (Ptr<OFSwitch13Device> switchDevice)
+{
+  NS_LOG_FUNCTION (this << switchDevice);
+
+  // A tabela de correspondência exata só encaminha as falhas para a tabela
+  // com curingas, que tem a regra de table-miss.
+  uint8_t table = 0;
+  if (switchDevice == switchDeviceHw && m_hwAggTable)
+    {
+      FlowModBuilder gotoAgg (OFPFC_ADD, 0, 0);
+      gotoAgg.GotoTable (m_hwAggTable);
+      SendRule (switchDevice, gotoAgg.Release ());
+      table = m_hwAggTable;
+    }
+
+  // Regra de table-miss explícita. No modo proativo, descarta e conta os
+  // pacotes sem regra, como os perdidos durante a migração de tráfegos. No
+  // modo reativo, envia os pacotes ao controlador.
+  FlowModBuilder miss (OFPFC_ADD, table, 0);
+  if (m_install == CustomController::REACTIVE_RULES)
+    {
+      miss.ApplyController (m_missLen);
+    }
+  SendRule (switchDevice, miss.Release ());
+}
+
+BearerInfo*
+CustomController::FindPacketBearer (const struct ofl_msg_packet_in *msg,
+                                    bool uplink)
+{
+  NS_LOG_FUNCTION (this << uplink);
+
+  struct ofl_match *match = (struct ofl_match*)msg->match;
+  struct ofl_match_tlv *tlvIp =
+    oxm_match_lookup (uplink ? OXM_OF_IPV4_SRC : OXM_OF_IPV4_DST, match);
+  struct ofl_match_tlv *tlvProto = oxm_match_lookup (OXM_OF_IP_PROTO, match);
+  if (!tlvIp || !tlvProto)
+    {
+      return 0;
+    }
+
+  // O IP do cliente está na ordem de rede, como na instalação das regras.
+  uint32_t ip;
+  memcpy (&ip, tlvIp->value, sizeof (uint32_t));
+  Ipv4Address ipAddr (ntohl (ip));
+  uint8_t proto = *tlvProto->value;
+
+  // A porta da aplicação é o destino no uplink e a origem no downlink.
+  uint32_t portField = proto == 6
+    ? (uplink ? OXM_OF_TCP_DST : OXM_OF_TCP_SRC)
+    : (uplink ? OXM_OF_UDP_DST : OXM_OF_UDP_SRC);
+  struct ofl_match_tlv *tlvPort = oxm_match_lookup (portField, match);
+  if (!tlvPort)
+    {
+      return 0;
+    }
+  uint16_t port;
+  memcpy (&port, tlvPort->value, sizeof (uint16_t));
+
+  return m_bearers.Find (ipAddr, proto, port);
+}
+
+void
+CustomController::InstallMeter (Ptr<OFSwitch13Device> switchDevice,
+                                const BearerInfo &bearer)
+{
+  NS_LOG_FUNCTION (this << switchDevice << bearer.teid);
+
+  // Rajada equivalente a 100ms na taxa do medidor.
+  uint32_t kbps = std::max<uint64_t> (1, GetMeterRate (bearer).GetBitRate () / 1000);
+  uint32_t burst = std::max<uint32_t> (1, kbps / 10);
+
+  // O medidor ainda existe no switch quando o tráfego retorna durante o
+  // escoamento da migração anterior. Nesse caso, apenas a taxa é alterada.
+  auto ret = m_meters.insert (
+      std::make_pair (switchDevice->GetDatapathId (), bearer.teid));
+  MeterModBuilder meter (ret.second ? OFPMC_ADD : OFPMC_MODIFY, bearer.teid);
+  if (m_meterPol == CustomController::METER_DROP)
+    {
+      meter.Drop (kbps, burst);
+    }
+  else
+    {
+      meter.DscpRemark (kbps, burst, 1);
+    }
+
+  SendRule (switchDevice, meter.Release ());
+}
+
+void
+CustomController::RemoveMeter (Ptr<OFSwitch13Device> switchDevice,
+                               uint32_t teid)
+{
+  NS_LOG_FUNCTION (this << switchDevice << teid);
+
+  if (m_meterPol == CustomController::NO_METER)
+    {
+      return;
+    }
+
+  if (!m_meters.erase (std::make_pair (switchDevice->GetDatapathId (), teid)))
+    {
+      return;
+    }
+
+  MeterModBuilder meter (OFPMC_DELETE, teid);
+  SendRule (switchDevice, meter.Release ());
+}
+
+DataRate
+CustomController::GetMeterRate (const BearerInfo &bearer) const
+{
+  GbrQosInformation qos = bearer.app->GetEpsBearer ().gbrQosInfo;
+  uint64_t mbr = qos.mbrDl + qos.mbrUl;
+  if (mbr)
+    {
+      return DataRate (mbr);
+    }
+  return DataRate (static_cast<uint64_t> (bearer.expected * m_meterFactor));
+}
+
+void
+CustomController::MoveUnitRules (const MoveUnit &unit,
+                                 Ptr<OFSwitch13Device> dstSwitchDevice)
+{
+  NS_LOG_FUNCTION (this << unit.id << dstSwitchDevice);
+
+  if (m_migMode == CustomController::GROUPS)
+    {
+      MoveGroupRules (unit.switchDevice, dstSwitchDevice, unit.id, unit.teids);
+    }
+  else
+    {
+      MoveTrafficRules (unit.switchDevice, dstSwitchDevice, unit.id);
+    }
+}
+
+void
+CustomController::UpdateHwCache (const std::vector<MoveUnit*> &hwUnits,
+                                 const std::vector<MoveUnit*> &swUnits,
+                                 double &tabHwUsed, double &bpsHwUsed,
+                                 double &tabSwUsed, double &bpsSwUsed,
+                                 RebalanceStats &stats)
+{
+  NS_LOG_FUNCTION (this);
+
+  // O HW é ocupado até a marca superior e o SW até o limiar de bloqueio.
+  double tabHwSize = switchDeviceHw->GetFlowTableSize (0) * m_highMark;
+  double bpsHwSize =
+    switchDeviceHw->GetCpuCapacity ().GetBitRate () * m_highMark;
+  double tabSwSize = switchDeviceSw->GetFlowTableSize (0) * m_blockThs;
+  double bpsSwSize =
+    switchDeviceSw->GetCpuCapacity ().GetBitRate () * m_blockThs;
+
+  // Vítimas: unidades que continuam no HW, da mais fria para a mais quente.
+  std::vector<MoveUnit*> victims;
+  for (auto unit : hwUnits)
+    {
+      if (unit->switchDevice == switchDeviceHw)
+        {
+          victims.push_back (unit);
+        }
+    }
+  std::stable_sort (victims.begin (), victims.end (),
+                    [] (const MoveUnit *a, const MoveUnit *b)
+    {
+      return a->heat < b->heat;
+    });
+
+  // Candidatas: unidades ativas no SW, da mais quente para a mais fria. As
+  // ociosas não são promovidas, pois seriam logo rebaixadas.
+  std::vector<MoveUnit*> candidates;
+  for (auto unit : swUnits)
+    {
+      if (unit->bps >= m_idleRate.GetBitRate ())
+        {
+          candidates.push_back (unit);
+        }
+    }
+  std::stable_sort (candidates.begin (), candidates.end (),
+                    [] (const MoveUnit *a, const MoveUnit *b)
+    {
+      return a->heat > b->heat;
+    });
+
+  size_t next = 0;
+  for (auto unit : candidates)
+    {
+      // Seleciona as vítimas mais frias que a candidata até que ela caiba no
+      // HW, desde que o SW tenha recursos para recebê-las.
+      double tabHw = tabHwUsed;
+      double bpsHw = bpsHwUsed;
+      double tabSw = tabSwUsed - unit->entries;
+      double bpsSw = bpsSwUsed - unit->bps;
+      size_t last = next;
+      while ((tabHw + unit->entries > tabHwSize
+              || bpsHw + unit->bps > bpsHwSize)
+             && last < victims.size () && victims [last]->heat < unit->heat
+             && tabSw + victims [last]->entries <= tabSwSize
+             && bpsSw + victims [last]->bps <= bpsSwSize)
+        {
+          tabHw -= victims [last]->entries;
+          bpsHw -= victims [last]->bps;
+          tabSw += victims [last]->entries;
+          bpsSw += victims [last]->bps;
+          last++;
+        }
+      if (tabHw + unit->entries > tabHwSize || bpsHw + unit->bps > bpsHwSize)
+        {
+          continue;
+        }
+
+      for (; next < last; next++)
+        {
+          MoveUnit *victim = victims [next];
+          NS_LOG_DEBUG ("Evicting unit " << victim->id << " to SW switch.");
+          MoveUnitRules (*victim, switchDeviceSw);
+          victim->switchDevice = switchDeviceSw;
+          stats.demoted += victim->teids.size ();
+          stats.evicted += victim->teids.size ();
+        }
+
+      NS_LOG_DEBUG ("Moving unit " << unit->id << " to HW switch.");
+      MoveUnitRules (*unit, switchDeviceHw);
+      unit->switchDevice = switchDeviceHw;
+      stats.promoted += unit->teids.size ();
+
+      tabHwUsed = tabHw + unit->entries;
+      bpsHwUsed = bpsHw + unit->bps;
+      tabSwUsed = tabSw;
+      bpsSwUsed = bpsSw;
+    }
+}
+
+void
+CustomController::SetTrafficMatch (FlowModBuilder &ruleUl,
+                                   FlowModBuilder &ruleDl,
+                                   const BearerInfo &bearer)
+{
+  NS_LOG_FUNCTION (this << bearer.teid);
+
+  // Identificando o tráfego pelo teid no cookie.
+  ruleUl.SetCookie (bearer.teid).MatchEthType (0x800).MatchIpv4Src (bearer.ipAddr);
+  ruleDl.SetCookie (bearer.teid).MatchEthType (0x800).MatchIpv4Dst (bearer.ipAddr);
+
+  if (bearer.ipProto == 6)
+    {
+      // Regras específicas para protocolo TCP.
+      ruleUl.MatchIpProto (6).MatchTcpDst (bearer.port);
+      ruleDl.MatchIpProto (6).MatchTcpSrc (bearer.port);
+    }
+  else
+    {
+      // Regras específicas para protocolo UDP.
+      ruleUl.MatchIpProto (17).MatchUdpDst (bearer.port);
+      ruleDl.MatchIpProto (17).MatchUdpSrc (bearer.port);
+    }
+}
+
+DataRate
+CustomController::GetExpectedRate (uint32_t teid)
+{
+  // Vazão média nas duas direções, a partir dos modelos de tráfego em
+  // TrafficHelper::ConfigureHelpers (), incluindo 42 bytes de cabeçalhos
+  // Ethernet, IP e UDP por pacote. Para os vídeos, usamos a vazão média dos
+  // traces de cada grupo (GBR ou Non-GBR).
+  switch (teid & 0xF)
+    {
+    case 1:   // BufVideo: traces Non-GBR.
+      return DataRate ("620Kbps");
+    case 2:   // HttpPage: páginas com leitura entre as requisições.
+    case 3:
+      return DataRate ("100Kbps");
+    case 4:   // AutPilot: 1kB a cada 62.5ms (UL) e a cada 1s (DL).
+    case 5:
+      return DataRate ("145Kbps");
+    case 6:   // GameOpen: 42B a cada 86ms (UL) e 172B a cada 44ms (DL).
+      return DataRate ("47Kbps");
+    case 7:   // GameTeam: 77B a cada 36ms (UL) e 241B a cada 43ms (DL).
+      return DataRate ("79Kbps");
+    case 8:   // VoipCall: 20B a cada 20ms em cada direção.
+      return DataRate ("50Kbps");
+    case 9:   // BikeRace: 1kB a cada 300ms em cada direção.
+      return DataRate ("57Kbps");
+    case 10:  // GpsTrack: 512B a cada 13s em cada direção.
+      return DataRate ("1Kbps");
+    case 11:  // LivVideo: traces GBR (office-cam).
+      return DataRate ("200Kbps");
+    case 12:  // LivVideo: traces Non-GBR.
+      return DataRate ("613Kbps");
+    default:
+      return DataRate ("100Kbps");
+    }
+}
+
+Time
+CustomController::GetExpectedEnd (Ptr<SvelteClient> app)
+{
+  // A aplicação inicia em +1 segundo e encerra ao final do tamanho do tráfego,
+  // limitado pela duração máxima definida pelo TrafficManager.
+  Time length = app->GetExpectedLength ();
+  if (!app->GetMaxOnTime ().IsZero ())
+    {
+      length = std::min (length, app->GetMaxOnTime ());
+    }
+  return Simulator::Now () + Seconds (1) + length;
+}
+
+void
+CustomController::SendRule (Ptr<OFSwitch13Device> switchDevice,
+                            struct ofl_msg_header *msg)
+{
+  NS_LOG_FUNCTION (this << switchDevice << msg);
+
+  // As mensagens são enfileiradas por switch e enviadas em rajada ao final da
+  // janela de agrupamento, delimitada por uma única mensagem de barreira.
+  uint64_t dpId = switchDevice->GetDatapathId ();
+  RuleBatch &batch = m_ruleBatches [dpId];
+  batch.queued++;
+
+  // Uma remoção por cookie torna desnecessárias as instalações pendentes
+  // com o mesmo cookie e as remoções idênticas ainda não enviadas.
+  if (msg->type == OFPT_FLOW_MOD)
+    {
+      struct ofl_msg_flow_mod *flowMod = (struct ofl_msg_flow_mod*)msg;
+      if (flowMod->command == OFPFC_DELETE)
+        {
+          auto it = batch.msgs.begin ();
+          while (it != batch.msgs.end ())
+            {
+              if ((*it)->type != OFPT_FLOW_MOD)
+                {
+                  it++;
+                  continue;
+                }
+
+              struct ofl_msg_flow_mod *queued = (struct ofl_msg_flow_mod*)*it;
+              bool sameCookie = (queued->cookie & flowMod->cookie_mask)
+                == (flowMod->cookie & flowMod->cookie_mask);
+              bool sameTable = flowMod->table_id == OFPTT_ALL
+                || flowMod->table_id == queued->table_id;
+              bool sameDelete = queued->command == OFPFC_DELETE
+                && queued->cookie_mask == flowMod->cookie_mask
+                && queued->table_id == flowMod->table_id;
+
+              if (sameCookie && sameTable
+                  && (queued->command == OFPFC_ADD || sameDelete))
+                {
+                  NS_LOG_DEBUG ("Coalescing rule with cookie " <<
+                                GetUint32Hex (queued->cookie) <<
+                                " on switch " << dpId);
+                  ofl_msg_free (*it, 0);
+                  it = batch.msgs.erase (it);
+                  continue;
+                }
+              it++;
+            }
+        }
+    }
+  batch.msgs.push_back (msg);
+  ScheduleFlush (dpId);
+}
+
+void
+CustomController::ScheduleFlush (uint64_t dpId)
+{
+  NS_LOG_FUNCTION (this << dpId);
+
+  // Enquanto a conexão OpenFlow com o switch não estiver estabelecida, as
+  // mensagens ficam guardadas para envio ao final do handshake, assim como
+  // ocorre com os comandos agendados pelo DpctlSchedule.
+  RuleBatch &batch = m_ruleBatches [dpId];
+  if (m_connected.find (dpId) != m_connected.end ()
+      && !batch.flushEvent.IsRunning ())
+    {
+      batch.flushEvent = Simulator::Schedule (
+          m_batchWindow, &CustomController::FlushRules, this, dpId);
+    }
+}
+
+void
+CustomController::FlushRules (uint64_t dpId)
+{
+  NS_LOG_FUNCTION (this << dpId);
+
+  RuleBatch &batch = m_ruleBatches [dpId];
+  batch.flushEvent.Cancel ();
+  if (batch.queued == 0 && batch.waiting.empty ())
+    {
+      return;
+    }
+
+  // Enviando a rajada de mensagens seguida de uma barreira. As migrações
+  // aguardando confirmação avançam com a resposta desta barreira.
+  Ptr<const RemoteSwitch> swtch = GetRemoteSwitch (dpId);
+  uint32_t sent = batch.msgs.size ();
+  for (auto msg : batch.msgs)
+    {
+      SendToSwitch (swtch, msg);
+      ofl_msg_free (msg, 0);
+    }
+  if (sent || !batch.waiting.empty () || !batch.setups.empty ())
+    {
+      struct ofl_msg_header barrier;
+      barrier.type = OFPT_BARRIER_REQUEST;
+      uint32_t xid = ++m_barrierXid;
+      SendToSwitch (swtch, &barrier, xid);
+      if (!batch.waiting.empty ())
+        {
+          m_barriers [std::make_pair (dpId, xid)].swap (batch.waiting);
+        }
+      if (!batch.setups.empty ())
+        {
+          m_setups [std::make_pair (dpId, xid)].swap (batch.setups);
+        }
+      if (batch.freed)
+        {
+          m_releases.insert (std::make_pair (dpId, xid));
+        }
+    }
+
+  NS_LOG_DEBUG ("Switch " << dpId << " batch with " << batch.queued <<
+                " rules queued and " << sent << " rules sent.");
+  m_batchTrace (dpId, batch.queued, sent);
+  batch.msgs.clear ();
+  batch.queued = 0;
+  batch.freed = false;
+}
+
+void
+CustomController::ReadFlowStats (Ptr<OFSwitch13Device> switchDevice)
+{
+  NS_LOG_FUNCTION (this << switchDevice);
+
+  // Percorremos toda a tabela, pois uma regra que substitui outra com a mesma
+  // identificação (como no retorno de um tráfego ao switch durante o
+  // escoamento) ocupa a posição da anterior. Os contadores são copiados a
+  // cada consulta, sem guardar referências às entradas do switch.
+  struct datapath *datapath = switchDevice->GetDatapathStruct ();
+  struct flow_table *table = datapath->pipeline->tables[0];
+  struct flow_entry *entry;
+
+  LIST_FOR_EACH (entry, struct flow_entry, match_node, &table->match_entries)
+  {
+    BearerInfo *bearer = m_bearers.Find (entry->stats->cookie);
+    if (!bearer || bearer->switchDevice != switchDevice || bearer->ruleWait)
+      {
+        // Regras de outros tipos ou aguardando remoção.
+        continue;
+      }
+
+    bearer->entries++;
+    bearer->bytes += entry->stats->byte_count;
+    bearer->pkts += entry->stats->packet_count;
+  }
+}
+
+void
+CustomController::ControllerTimeout ()
+{
+  NS_LOG_FUNCTION (this);
+
+  // Escalona a próxima operação de timeout para o controlador.
+  Simulator::Schedule (m_timeout, &CustomController::ControllerTimeout, this );
+
+  // Para o roteamento por IP há apenas o descarte das requisições expiradas,
+  // mesmo sem liberação de recursos.
+  if (!m_qosRoute)
+    {
+      ProcessPendingRequests ();
+      return;
+    }
+
+  // O roteamento é por QoS. Vamos atualizar a vazão dos tráfegos e rebalancear
+  // a carga entre os switches HW e SW.
+  UpdateTrafficRates ();
+  RebalanceSwitches ();
+}
+
+void
+CustomController::UpdateTrafficRates ()
+{
+  NS_LOG_FUNCTION (this);
+
+  // Vamos ler os contadores das regras nos switches HW e SW e atualizar o
+  // estimador de vazão de cada tráfego.
+  for (auto &bearer : m_bearers)
+    {
+      bearer.entries = 0;
+      bearer.bytes = 0;
+      bearer.pkts = 0;
+    }
+  ReadFlowStats (switchDeviceSw);
+  ReadFlowStats (switchDeviceHw);
+
+  for (auto &bearer : m_bearers)
+    {
+      if (bearer.entries < 2)
+        {
+          continue;
+        }
+
+      // Temos sempre duas regras para cada tráfego (uplink e downlink). O
+      // estimador recebe os bytes observados desde a última consulta.
+      uint64_t delta = bearer.bytes >= bearer.lastBytes
+        ? bearer.bytes - bearer.lastBytes : bearer.bytes;
+      bearer.rate.Update (delta, Simulator::Now ());
+
+      // Contadores do cache: a última atividade (LRU) e os bytes com
+      // envelhecimento pela metade a cada consulta (LFU).
+      uint64_t pktDelta = bearer.pkts >= bearer.lastPkts
+        ? bearer.pkts - bearer.lastPkts : bearer.pkts;
+      if (delta)
+        {
+          bearer.lastHit = Simulator::Now ();
+        }
+      bearer.hitBytes = bearer.hitBytes / 2 + delta;
+      if (bearer.switchDevice == switchDeviceHw)
+        {
+          m_hwBytes += delta;
+          m_hwPkts += pktDelta;
+        }
+      else
+        {
+          m_swBytes += delta;
+          m_swPkts += pktDelta;
+        }
+      bearer.lastBytes = bearer.bytes;
+      bearer.lastPkts = bearer.pkts;
+      bearer.lastUpdate = Simulator::Now ();
+      NS_LOG_DEBUG ("Traffic " << bearer.teid <<
+                    " with throughput " << bearer.rate.GetRate ());
+    }
+}
+
+void
+CustomController::RebalanceSwitches ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  m_lastRebal = now;
+  for (auto &it : m_overloads)
+    {
+      if (it.second.active)
+        {
+          it.second.rebalances++;
+        }
+    }
+
+  // Verificando os recursos nos switches de HW e SW.
+  uint32_t tabHwSize = switchDeviceHw->GetFlowTableSize (0);
+  uint64_t bpsHwSize = switchDeviceHw->GetCpuCapacity ().GetBitRate ();
+  uint32_t tabSwSize = switchDeviceSw->GetFlowTableSize (0);
+  uint64_t bpsSwSize = switchDeviceSw->GetCpuCapacity ().GetBitRate ();
+
+  RebalanceStats stats;
+  stats.promoted = 0;
+  stats.demoted = 0;
+  stats.evicted = 0;
+  stats.hwTabBefore = switchDeviceHw->GetFlowTableUsage (0);
+  stats.hwCpuBefore = switchDeviceHw->GetCpuUsage ();
+  stats.swTabBefore = switchDeviceSw->GetFlowTableUsage (0);
+  stats.swCpuBefore = switchDeviceSw->GetCpuUsage ();
+
+  // Uso previsto após as movimentações (em entradas e bps).
+  double tabHwUsed = switchDeviceHw->GetFlowTableEntries (0);
+  double bpsHwUsed = switchDeviceHw->GetCpuLoad ().GetBitRate ();
+  double tabSwUsed = switchDeviceSw->GetFlowTableEntries (0);
+  double bpsSwUsed = switchDeviceSw->GetCpuLoad ().GetBitRate ();
+
+  // Agrupando os tráfegos nas unidades de movimentação: cada tráfego na
+  // migração por regras, ou todos os tráfegos do cliente na migração por
+  // grupos. Uma unidade só pode ser movida com todas as entradas localizadas
+  // e após o tempo mínimo de permanência no switch.
+  bool byGroup = m_migMode == CustomController::GROUPS;
+  std::vector<MoveUnit> units;
+  std::map<uint32_t, size_t> unitIdx;
+  for (auto &bearer : m_bearers)
+    {
+      uint32_t id = byGroup ? bearer.group : bearer.teid;
+      auto ret = unitIdx.insert (std::make_pair (id, units.size ()));
+      if (ret.second)
+        {
+          Time lastMove = byGroup ? m_groups [id].lastMove : bearer.lastMove;
+          MoveUnit unit;
+          unit.id = id;
+          unit.switchDevice = bearer.switchDevice;
+          unit.bps = 0;
+          unit.remBytes = 0;
+          unit.heat = 0;
+          unit.entries = 0;
+          unit.ready = lastMove.IsZero () || now - lastMove >= m_minResidence;
+          units.push_back (unit);
+        }
+
+      MoveUnit &unit = units [ret.first->second];
+      uint64_t bps = bearer.rate.GetRate ().GetBitRate ();
+      Time remaining = std::max (Time (0), bearer.endTime - now);
+      unit.bps += bps;
+      unit.remBytes += bps * remaining.GetSeconds () / 8;
+      unit.heat = m_cachePol == CustomController::CACHE_LRU
+        ? std::max (unit.heat, bearer.lastHit.GetSeconds ())
+        : unit.heat + bearer.hitBytes;
+      unit.entries += 2;
+      unit.teids.push_back (bearer.teid);
+      if (bearer.entries < 2)
+        {
+          unit.ready = false;
+        }
+    }
+
+  std::vector<MoveUnit*> hwUnits, swUnits;
+  for (auto &unit : units)
+    {
+      if (unit.ready)
+        {
+          (unit.switchDevice == switchDeviceHw ? hwUnits : swUnits).push_back (&unit);
+        }
+    }
+
+  // O valor de uma unidade é a sua vazão ou, considerando o tempo de vida,
+  // os bytes restantes até o fim previsto dos seus tráfegos.
+  bool byBytes = m_offValue == CustomController::REMAINING_BYTES;
+  auto value = [byBytes] (const MoveUnit *unit)
+    {
+      return byBytes ? unit->remBytes : static_cast<double> (unit->bps);
+    };
+
+  // Rebaixando para o SW as unidades de HW com menor valor. As unidades
+  // ociosas sempre são rebaixadas. As demais só quando o HW estiver acima da
+  // marca superior, até que o uso fique abaixo da marca inferior.
+  std::stable_sort (hwUnits.begin (), hwUnits.end (),
+                    [&value] (const MoveUnit *a, const MoveUnit *b)
+    {
+      return value (a) < value (b);
+    });
+  bool hwOverload = tabHwUsed > tabHwSize * m_highMark
+    || bpsHwUsed > bpsHwSize * m_highMark;
+  for (auto unit : hwUnits)
+    {
+      bool idle = unit->bps < m_idleRate.GetBitRate ();
+      bool overLow = tabHwUsed > tabHwSize * m_lowMark
+        || bpsHwUsed > bpsHwSize * m_lowMark;
+      if (!idle && !(hwOverload && overLow))
+        {
+          continue;
+        }
+
+      // A unidade só é rebaixada se houver recursos no SW.
+      if (tabSwUsed + unit->entries > tabSwSize * m_blockThs
+          || bpsSwUsed + unit->bps > bpsSwSize * m_blockThs)
+        {
+          continue;
+        }
+
+      NS_LOG_DEBUG ("Moving unit " << unit->id << " to SW switch.");
+      MoveUnitRules (*unit, switchDeviceSw);
+      unit->switchDevice = switchDeviceSw;
+      tabHwUsed -= unit->entries;
+      bpsHwUsed -= unit->bps;
+      tabSwUsed += unit->entries;
+      bpsSwUsed += unit->bps;
+      stats.demoted += unit->teids.size ();
+    }
+
+  // No modo cache, as promoções seguem a política de substituição do cache
+  // no lugar do plano de offload.
+  if (m_cachePol != CustomController::NO_CACHE)
+    {
+      UpdateHwCache (hwUnits, swUnits, tabHwUsed, bpsHwUsed, tabSwUsed,
+                     bpsSwUsed, stats);
+    }
+  else
+    {
+      // Verificando os recursos disponíveis no switch de HW até a marca
+      // superior.
+      uint32_t tabHwFree = std::max (0.0, tabHwSize * m_highMark - tabHwUsed);
+      uint64_t bpsHwFree = std::max (0.0, bpsHwSize * m_highMark - bpsHwUsed);
+      NS_LOG_DEBUG ("Resources on HW switch: " << tabHwFree <<
+                    " table entries and " << bpsHwFree << " CPU bps free.");
+
+      // Montando o problema de empacotamento com as unidades candidatas.
+      // Unidades ociosas não são promovidas para evitar que voltem logo em
+      // seguida, nem as que estão no fim da vida, que não compensam o custo
+      // da migração.
+      OffloadPlanner planner (tabHwFree, bpsHwFree);
+      std::map<uint32_t, MoveUnit*> unitById;
+      for (auto unit : swUnits)
+        {
+          if (unit->bps < m_idleRate.GetBitRate () || value (unit) <= 0)
+            {
+              continue;
+            }
+          planner.AddCandidate (unit->id, value (unit), unit->bps,
+                                unit->entries);
+          unitById [unit->id] = unit;
+        }
+
+      // Calculando apenas o plano da estratégia configurada ou, na
+      // comparação, o plano de todas as estratégias, mas aplicando apenas o
+      // da estratégia configurada.
+      OffloadPlanner::Plan selected;
+      for (int s = OffloadPlanner::GREEDY; s <= OffloadPlanner::EXACT; s++)
+        {
+          OffloadPlanner::Strategy strategy =
+            static_cast<OffloadPlanner::Strategy> (s);
+          bool applied = strategy == m_offStrategy;
+          if (!applied && !m_offCompare)
+            {
+              continue;
+            }
+
+          OffloadPlanner::Plan plan = planner.Solve (strategy, m_exactLimit);
+          if (applied)
+            {
+              selected = plan;
+            }
+          if (plan.fallback)
+            {
+              NS_LOG_DEBUG ("Exact strategy fell back to heuristic.");
+            }
+
+          double tabUse = (tabHwUsed + plan.entries) / tabHwSize;
+          double cpuUse = (bpsHwUsed + plan.bps) / bpsHwSize;
+          m_offloadTrace (OffloadPlanner::StrategyStr (strategy), applied,
+                          plan.fallback, plan.teids.size (), tabUse, cpuUse);
+        }
+
+      // Move as unidades selecionadas do switch de SW para o switch de HW.
+      for (auto id : selected.teids)
+        {
+          MoveUnit *unit = unitById [id];
+          NS_LOG_DEBUG ("Moving unit " << id << " to HW switch.");
+          MoveUnitRules (*unit, switchDeviceHw);
+          tabHwUsed += unit->entries;
+          bpsHwUsed += unit->bps;
+          tabSwUsed -= unit->entries;
+          bpsSwUsed -= unit->bps;
+          stats.promoted += unit->teids.size ();
+        }
+
+    }
+
+  // Reportando as movimentações e o uso previsto dos switches.
+  stats.hwTabAfter = tabHwUsed / tabHwSize;
+  stats.hwCpuAfter = bpsHwUsed / bpsHwSize;
+  stats.swTabAfter = std::max (0.0, tabSwUsed) / tabSwSize;
+  stats.swCpuAfter = std::max (0.0, bpsSwUsed) / bpsSwSize;
+  stats.hwBearers = 0;
+  for (auto const &bearer : m_bearers)
+    {
+      if (bearer.switchDevice == switchDeviceHw)
+        {
+          stats.hwBearers++;
+        }
+    }
+  stats.hwBytes = m_hwBytes;
+  stats.swBytes = m_swBytes;
+  stats.hwPkts = m_hwPkts;
+  stats.swPkts = m_swPkts;
+  m_rebalanceTrace (stats);
+
+  // As reservas foram atualizadas pelas movimentações. Aproveitamos também
+  // para descartar as requisições expiradas.
+  ProcessPendingRequests ();
+}
+
+void
+CustomController::SampleSwitchLoad ()
+{
+  NS_LOG_FUNCTION (this);
+
+  // Escalona a próxima amostragem de carga dos switches.
+  Simulator::Schedule (m_loadSampling, &CustomController::SampleSwitchLoad, this);
+
+  Ptr<OFSwitch13Device> devices [] = {switchDeviceHw, switchDeviceSw};
+  for (auto switchDevice : devices)
+    {
+      if (!switchDevice)
+        {
+          continue;
+        }
+
+      uint64_t dpId = switchDevice->GetDatapathId ();
+      auto ret = m_loadEst.insert (std::make_pair (dpId, LoadEstimator ()));
+      LoadEstimator &estimator = ret.first->second;
+      if (ret.second)
+        {
+          estimator.Configure (m_loadAlpha, m_loadWindow, m_loadPct);
+        }
+
+      double usage = switchDevice->GetCpuUsage ();
+      estimator.Update (usage, Simulator::Now ());
+      m_loadTrace (dpId, usage, estimator.Get (LoadEstimator::EWMA),
+                   estimator.Get (LoadEstimator::PEAK),
+                   estimator.Get (LoadEstimator::PERCENTILE));
+    }
+}
 
-      // Move o tráfego do switch de SW para o switch de HW.
-      NS_LOG_DEBUG ("Moving traffic " << element.first << " to HW switch.");
-      MoveTrafficRules (switchDeviceSw, switchDeviceHw, element.first);
-      tabHwFree -= 2;
-      bpsHwFree -= element.second.GetBitRate ();
+double
+CustomController::GetSwitchLoad (Ptr<OFSwitch13Device> switchDevice)
+{
+  // A leitura instantânea não depende da amostragem.
+  auto it = m_loadEst.find (switchDevice->GetDatapathId ());
+  if (m_loadView == LoadEstimator::INSTANT || it == m_loadEst.end ())
+    {
+      return switchDevice->GetCpuUsage ();
     }
+  return it->second.Get (m_loadView);
+}
+
+void
+CustomController::TriggerRebalance ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_qosRoute || !m_eventRebal || m_rebalEvent.IsRunning ())
+    {
+      return;
+    }
+
+  // Respeitando o intervalo mínimo entre rebalanceamentos. Se ainda for cedo,
+  // o rebalanceamento é agendado para o fim do intervalo.
+  Time wait = Time (0);
+  if (!m_lastRebal.IsZero () && Simulator::Now () - m_lastRebal < m_rebalGap)
+    {
+      wait = m_lastRebal + m_rebalGap - Simulator::Now ();
+    }
+
+  m_rebalEvent = Simulator::Schedule (
+      wait, &CustomController::OverloadRebalance, this);
+}
+
+void
+CustomController::OverloadRebalance ()
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_LOG_DEBUG ("Rebalance triggered by switch overload.");
+  UpdateTrafficRates ();
+  RebalanceSwitches ();
+}
+
+bool
+CustomController::IsOverloaded (Ptr<OFSwitch13Device> switchDevice) const
+{
+  // O switch HW é considerado sobrecarregado acima da marca superior e o
+  // switch SW acima do limite de bloqueio.
+  double threshold = switchDevice == switchDeviceHw ? m_highMark : m_blockThs;
+  return switchDevice->GetFlowTableUsage (0) > threshold
+         || switchDevice->GetCpuUsage () > threshold;
+}
+
+void
+CustomController::NotifyDatapathTimeout (std::string context,
+                                         Ptr<const OFSwitch13Device> device)
+{
+  Ptr<OFSwitch13Device> switchDevice = GetSwitchDevice (context);
+  OverloadInfo &info = m_overloads [switchDevice->GetDatapathId ()];
+
+  bool dropped = info.drops != info.lastDrops;
+  info.lastDrops = info.drops;
+  if (IsOverloaded (switchDevice) || dropped)
+    {
+      // Início ou continuação de uma sobrecarga.
+      if (!info.active)
+        {
+          info.active = true;
+          info.onset = Simulator::Now ();
+        }
+      TriggerRebalance ();
+    }
+  else if (info.active)
+    {
+      // Fim da sobrecarga: reportando o tempo até o alívio e os descartes.
+      m_overloadTrace (switchDevice->GetDatapathId (),
+                       Simulator::Now () - info.onset, info.drops,
+                       info.rebalances);
+      info.active = false;
+      info.drops = info.lastDrops = 0;
+      info.rebalances = 0;
+    }
+}
+
+void
+CustomController::NotifyOverloadDrop (std::string context,
+                                      Ptr<const Packet> packet)
+{
+  Ptr<OFSwitch13Device> switchDevice = GetSwitchDevice (context);
+  OverloadInfo &info = m_overloads [switchDevice->GetDatapathId ()];
+
+  // O descarte por sobrecarga inicia o intervalo imediatamente.
+  info.drops++;
+  if (!info.active)
+    {
+      info.active = true;
+      info.onset = Simulator::Now ();
+    }
+  TriggerRebalance ();
+}
+
+Ptr<OFSwitch13Device>
+CustomController::GetSwitchDevice (std::string context) const
+{
+  return context == "Hw" ? switchDeviceHw : switchDeviceSw;
+}
+
+void
+CustomController::WaitConfirmation (Ptr<OFSwitch13Device> switchDevice,
+                                    uint32_t migration)
+{
+  NS_LOG_FUNCTION (this << switchDevice << migration);
+
+  // A migração aguarda a barreira enviada ao final da próxima rajada, que
+  // confirma todas as mensagens enfileiradas até aqui.
+  uint64_t dpId = switchDevice->GetDatapathId ();
+  m_ruleBatches [dpId].waiting.push_back (migration);
+  ScheduleFlush (dpId);
+}
+
+void
+CustomController::StartMigration (uint32_t id, bool group,
+                                  Ptr<OFSwitch13Device> srcSwitchDevice,
+                                  Ptr<OFSwitch13Device> dstSwitchDevice)
+{
+  NS_LOG_FUNCTION (this << id << group << srcSwitchDevice << dstSwitchDevice);
+
+  uint32_t migrationId = ++m_migrationId;
+  Migration &migration = m_migrations [migrationId];
+  migration.id = id;
+  migration.group = group;
+  migration.srcSwitch = srcSwitchDevice;
+  migration.dstSwitch = dstSwitchDevice;
+  migration.stage = INSTALL;
+  migration.pending = 1;
+  migration.start = Simulator::Now ();
+  migration.missBase = GetTableMisses (srcSwitchDevice) +
+    GetTableMisses (dstSwitchDevice);
+
+  // Aguardando a confirmação das regras no switch de destino.
+  WaitConfirmation (dstSwitchDevice, migrationId);
+}
+
+void
+CustomController::AdvanceMigration (uint32_t migrationId)
+{
+  NS_LOG_FUNCTION (this << migrationId);
+
+  auto it = m_migrations.find (migrationId);
+  if (it == m_migrations.end () || --it->second.pending)
+    {
+      return;
+    }
+
+  Migration &migration = it->second;
+  switch (migration.stage)
+    {
+    case INSTALL:
+      {
+        // Regras confirmadas no destino: redirecionando os switches UL e DL.
+        migration.stage = REDIRECT;
+        migration.pending = 2;
+        if (migration.group)
+          {
+            UpdateGroupRules (migration.id);
+          }
+        else
+          {
+            UpdateDlUlRules (migration.id);
+          }
+        WaitConfirmation (switchDeviceUl, migrationId);
+        WaitConfirmation (switchDeviceDl, migrationId);
+        break;
+      }
+    case REDIRECT:
+      {
+        // Redirecionamento confirmado: aguardando os pacotes em trânsito para
+        // o switch de origem antes da remoção.
+        migration.stage = DRAIN;
+        Simulator::Schedule (m_drainTime, &CustomController::DrainMigration,
+                             this, migrationId);
+        break;
+      }
+    case REMOVE:
+      {
+        // Remoção confirmada: reportando a latência e as perdas.
+        uint64_t misses = GetTableMisses (migration.srcSwitch) +
+          GetTableMisses (migration.dstSwitch);
+        m_migrationTrace (migration.id, migration.dstSwitch == switchDeviceHw,
+                          Simulator::Now () - migration.start,
+                          misses - migration.missBase);
+        m_migrations.erase (it);
+
+        // As regras removidas do switch de origem podem atender as
+        // requisições em espera.
+        if (!m_pending.empty ())
+          {
+            ProcessPendingRequests ();
+          }
+        break;
+      }
+    default:
+      break;
+    }
+}
+
+void
+CustomController::DrainMigration (uint32_t migrationId)
+{
+  NS_LOG_FUNCTION (this << migrationId);
+
+  auto it = m_migrations.find (migrationId);
+  if (it == m_migrations.end ())
+    {
+      return;
+    }
+
+  Migration &migration = it->second;
+  migration.stage = REMOVE;
+  migration.pending = 1;
+  if (migration.group)
+    {
+      RemoveGroupRules (migration.srcSwitch, migration.id);
+    }
+  else
+    {
+      // Se o tráfego voltou para o switch de origem durante o escoamento,
+      // suas regras não podem ser removidas. A migração é encerrada pela
+      // barreira, como na remoção.
+      BearerInfo *bearer = m_bearers.Find (migration.id);
+      if (!bearer || bearer->switchDevice != migration.srcSwitch)
+        {
+          RemoveTrafficRules (migration.srcSwitch, migration.id);
+        }
+    }
+  WaitConfirmation (migration.srcSwitch, migrationId);
+}
+
+uint64_t
+CustomController::GetTableMisses (Ptr<OFSwitch13Device> switchDevice) const
+{
+  // A regra de table-miss tem a menor prioridade e fica no final da tabela.
+  // No pipeline dividido do switch HW, a regra de prioridade zero da tabela 0
+  // apenas encaminha para a tabela com curingas, onde fica a table-miss.
+  uint8_t tableId = switchDevice == switchDeviceHw ? m_hwAggTable : 0;
+  struct datapath *datapath = switchDevice->GetDatapathStruct ();
+  struct flow_table *table = datapath->pipeline->tables[tableId];
+  struct flow_entry *entry;
+
+  LIST_FOR_EACH_REVERSE (entry, struct flow_entry, match_node,
+                         &table->match_entries)
+  {
+    if (entry->stats->priority == 0)
+      {
+        return entry->stats->packet_count;
+      }
+    break;
+  }
+  return 0;
 }
 
 } // namespace ns3
@@ -28,12 +28,99 @@
 #include <ns3/network-module.h>
 #include <ns3/lte-module.h>
 #include "applications/svelte-client.h"
+#include "bearer-table.h"
+#include "load-estimator.h"
+#include "offload-planner.h"
+#include "rate-estimator.h"
 
 namespace ns3 {
 
+class FlowModBuilder;
+
 class CustomController : public OFSwitch13Controller
 {
 public:
+  /** Admission control mode. */
+  enum AdmissionMode
+  {
+    REACTIVE   = 0, //!< Instantaneous switch usage.
+    PREDICTIVE = 1  //!< Expected bitrate reservations.
+  };
+
+  /** Migration mode between HW and SW switches. */
+  enum MigrationMode
+  {
+    RULES  = 0,   //!< Per-traffic rules at UL and DL switches.
+    GROUPS = 1    //!< Per-client groups at UL and DL switches.
+  };
+
+  /** Rule installation mode at HW and SW switches. */
+  enum InstallMode
+  {
+    PROACTIVE_RULES = 0,  //!< Rules installed on bearer request.
+    REACTIVE_RULES  = 1   //!< Rules installed on the first packet-in.
+  };
+
+  /** Value of offload candidates. */
+  enum OffloadValue
+  {
+    THROUGHPUT      = 0,  //!< Estimated throughput.
+    REMAINING_BYTES = 1   //!< Throughput times the remaining lifetime.
+  };
+
+  /** Cache replacement policy for the HW switch. */
+  enum CachePolicy
+  {
+    NO_CACHE  = 0,  //!< Offload planner, no cache replacement.
+    CACHE_LRU = 1,  //!< Evict the least recently used traffics.
+    CACHE_LFU = 2   //!< Evict the least frequently used traffics.
+  };
+
+  /** Per-bearer meter policy at HW and SW switches. */
+  enum MeterPolicy
+  {
+    NO_METER     = 0,   //!< No meters.
+    METER_DROP   = 1,   //!< Drop packets above the meter rate.
+    METER_REMARK = 2    //!< Remark DSCP of packets above the meter rate.
+  };
+
+  /** Initial switch placement policy for QoS routing. */
+  enum PlacementPolicy
+  {
+    SW_FIRST    = 0,  //!< All traffics start on the SW switch.
+    CLASS_AWARE = 1   //!< Traffic class preference table and HW quotas.
+  };
+
+  /** Traffic class, from the application identified by the TEID. */
+  enum TrafficClass
+  {
+    ELASTIC   = 0,  //!< TCP traffics (BufVideo, HttpPage).
+    TELEMETRY = 1,  //!< Periodic messages (AutPilot, BikeRace, GpsTrack).
+    REALTIME  = 2,  //!< Latency-critical (GameOpen, GameTeam, VoipCall).
+    STREAMING = 3   //!< Live video (LivVideo).
+  };
+
+  /** Metadata associated to a rebalance operation. */
+  struct RebalanceStats
+  {
+    uint32_t promoted;      //!< Traffics moved from SW to HW.
+    uint32_t demoted;       //!< Traffics moved from HW to SW.
+    double   hwTabBefore;   //!< HW flow table usage before moves.
+    double   hwCpuBefore;   //!< HW CPU usage before moves.
+    double   swTabBefore;   //!< SW flow table usage before moves.
+    double   swCpuBefore;   //!< SW CPU usage before moves.
+    double   hwTabAfter;    //!< Expected HW flow table usage after moves.
+    double   hwCpuAfter;    //!< Expected HW CPU usage after moves.
+    double   swTabAfter;    //!< Expected SW flow table usage after moves.
+    double   swCpuAfter;    //!< Expected SW CPU usage after moves.
+    uint32_t hwBearers;     //!< Traffics on the HW switch after moves.
+    uint64_t hwBytes;       //!< Total bytes carried by the HW switch.
+    uint64_t swBytes;       //!< Total bytes carried by the SW switch.
+    uint64_t hwPkts;        //!< Total packets carried by the HW switch.
+    uint64_t swPkts;        //!< Total packets carried by the SW switch.
+    uint32_t evicted;       //!< Traffics evicted from the HW cache.
+  };
+
   CustomController ();            //!< Default constructor.
   virtual ~CustomController ();   //!< Dummy destructor, see DoDispose.
 
@@ -67,9 +154,11 @@ public:
    * \param dlPort The port connecting this switch to the DL switch.
    * \param hwPort The port connecting this switch to the HW switch.
    * \param swPort The port connecting this switch to the SW switch.
+   * \param exactTable The HW exact-match table size (0 for a single table).
    */
   //\{
-  void NotifyHwSwitch (Ptr<OFSwitch13Device> switchDevice, uint32_t ulPort, uint32_t dlPort);
+  void NotifyHwSwitch (Ptr<OFSwitch13Device> switchDevice, uint32_t ulPort, uint32_t dlPort,
+                       uint32_t exactTable = 0);
   void NotifySwSwitch (Ptr<OFSwitch13Device> switchDevice, uint32_t ulPort, uint32_t dlPort);
   void NotifyUlSwitch (Ptr<OFSwitch13Device> switchDevice, uint32_t hwPort, uint32_t swPort);
   void NotifyDlSwitch (Ptr<OFSwitch13Device> switchDevice, uint32_t hwPort, uint32_t swPort);
@@ -77,19 +166,66 @@ public:
 
   /**
    * Notify this controller of a new host connected to the OpenFlow switch.
+   * For clients sharing an access port, the address and mask identify the
+   * port subnet, and a single prefix rule covers all of them.
    * \param portNo The port number at the swithc.
    * \param ipAddr The host IP address.
+   * \param ipMask The host (or access port subnet) network mask.
    */
   //\{
-  void NotifyDl2Sv (uint32_t portNo, Ipv4Address ipAddr);
-  void NotifyUl2Cl (uint32_t portNo, Ipv4Address ipAddr);
+  void NotifyDl2Sv (uint32_t portNo, Ipv4Address ipAddr,
+                    Ipv4Mask ipMask = Ipv4Mask::GetOnes ());
+  void NotifyUl2Cl (uint32_t portNo, Ipv4Address ipAddr,
+                    Ipv4Mask ipMask = Ipv4Mask::GetOnes ());
   //\}
 
+  /**
+   * Notify this controller of a new access switch uplinked to the UL switch.
+   * \param switchDevice The OpenFlow access switch device.
+   * \param ulPort The port number at the access switch to the UL switch.
+   * \param acPort The port number at the UL switch to the access switch.
+   * \param ipAddr The access switch subnet address.
+   * \param ipMask The access switch subnet mask.
+   */
+  void NotifyAccessSwitch (Ptr<OFSwitch13Device> switchDevice, uint32_t ulPort,
+                           uint32_t acPort, Ipv4Address ipAddr, Ipv4Mask ipMask);
+
+  /**
+   * Notify this controller of a new host connected to an access switch.
+   * \param switchDevice The OpenFlow access switch device.
+   * \param portNo The port number at the access switch.
+   * \param ipAddr The host IP address.
+   * \param ipMask The host (or access port subnet) network mask.
+   */
+  void NotifyAc2Cl (Ptr<OFSwitch13Device> switchDevice, uint32_t portNo,
+                    Ipv4Address ipAddr, Ipv4Mask ipMask = Ipv4Mask::GetOnes ());
+
   /**
    * Notify this controller that all topology connections are done.
    */
   void NotifyTopologyBuilt ();
 
+  /**
+   * Get the traffic class for this traffic.
+   * \param teid The traffic ID.
+   * \return The traffic class.
+   */
+  static TrafficClass GetTrafficClass (uint32_t teid);
+
+  /**
+   * Get the string representing the given traffic class.
+   * \param cls The traffic class.
+   * \return The traffic class string.
+   */
+  static std::string TrafficClassStr (TrafficClass cls);
+
+  /**
+   * Get the DSCP value used to mark packets of the given traffic class.
+   * \param cls The traffic class.
+   * \return The DSCP value.
+   */
+  static uint8_t GetClassDscp (TrafficClass cls);
+
   /**
    * TracedCallback signature for request trace source.
    * \param teid The traffic ID.
@@ -103,6 +239,126 @@ public:
    */
   typedef void (*ReleaseTracedCallback)(uint32_t teid);
 
+  /**
+   * TracedCallback signature for overflow trace source.
+   * \param teid The traffic ID.
+   * \param dpId The datapath ID of the switch that accepted the traffic.
+   */
+  typedef void (*OverflowTracedCallback)(uint32_t teid, uint64_t dpId);
+
+  /**
+   * TracedCallback signature for preemption trace source.
+   * \param teid The preempted traffic ID.
+   * \param byTeid The traffic ID admitted by preemption.
+   */
+  typedef void (*PreemptTracedCallback)(uint32_t teid, uint32_t byTeid);
+
+  /**
+   * TracedCallback signature for admission queue trace source.
+   * \param teid The traffic ID.
+   * \param wait The time spent in the admission queue.
+   * \param admitted True if admitted, false if expired or evicted.
+   */
+  typedef void (*WaitTracedCallback)(uint32_t teid, Time wait, bool admitted);
+
+  /**
+   * TracedCallback signature for release deletes trace source.
+   * \param teid The traffic ID.
+   * \param sent The number of delete messages sent for this traffic.
+   * \param skipped The number of delete messages not needed for this traffic.
+   */
+  typedef void (*DeleteTracedCallback)(uint32_t teid, uint32_t sent,
+                                       uint32_t skipped);
+
+  /**
+   * TracedCallback signature for rule batch trace source.
+   * \param dpId The switch datapath ID.
+   * \param queued The number of messages queued for this batch.
+   * \param sent The number of messages effectively sent in this batch.
+   */
+  typedef void (*BatchTracedCallback)(uint64_t dpId, uint32_t queued,
+                                      uint32_t sent);
+
+  /**
+   * TracedCallback signature for offload plan trace source.
+   * \param strategy The offload strategy name.
+   * \param applied True if this plan was applied, false otherwise.
+   * \param fallback True if the exact strategy fell back to the heuristic.
+   * \param moved The number of traffics in this plan.
+   * \param tabUse The HW flow table usage after this plan.
+   * \param cpuUse The HW CPU usage after this plan.
+   */
+  typedef void (*OffloadTracedCallback)(std::string strategy, bool applied,
+                                        bool fallback, uint32_t moved,
+                                        double tabUse, double cpuUse);
+
+  /**
+   * TracedCallback signature for rebalance trace source.
+   * \param stats The rebalance statistics.
+   */
+  typedef void (*RebalanceTracedCallback)(const RebalanceStats &stats);
+
+  /**
+   * TracedCallback signature for overload trace source.
+   * \param dpId The switch datapath ID.
+   * \param duration The time from overload onset to relief.
+   * \param drops The number of packets dropped by overload in this interval.
+   * \param rebalances The number of rebalances in this interval.
+   */
+  typedef void (*OverloadTracedCallback)(uint64_t dpId, Time duration,
+                                         uint32_t drops, uint32_t rebalances);
+
+  /**
+   * TracedCallback signature for migration trace source.
+   * \param id The traffic ID or group ID.
+   * \param toHw True when moving to HW switch, false for SW switch.
+   * \param latency The time from the first install to the confirmed removal.
+   * \param lost The table misses at the HW and SW switches during the
+   *        migration. This is a switch-wide count that includes the misses
+   *        of other traffics and concurrent migrations.
+   */
+  typedef void (*MigrationTracedCallback)(uint32_t id, bool toHw,
+                                          Time latency, uint64_t lost);
+
+  /**
+   * TracedCallback signature for switch load trace source.
+   * \param dpId The switch datapath ID.
+   * \param sample The CPU usage sample.
+   * \param ewma The EWMA CPU usage.
+   * \param peak The peak CPU usage within the window.
+   * \param percentile The percentile CPU usage within the window.
+   */
+  typedef void (*LoadTracedCallback)(uint64_t dpId, double sample,
+                                     double ewma, double peak,
+                                     double percentile);
+
+  /**
+   * TracedCallback signature for packet-in trace source.
+   * \param dpId The switch datapath ID.
+   * \param teid The traffic ID (zero for unknown traffic).
+   * \param duplicate True when the rules were already installed.
+   */
+  typedef void (*PacketInTracedCallback)(uint64_t dpId, uint32_t teid,
+                                         bool duplicate);
+
+  /**
+   * TracedCallback signature for reactive rule setup trace source.
+   * \param teid The traffic ID.
+   * \param dpId The switch datapath ID.
+   * \param latency The interval between the packet-in and the confirmation.
+   */
+  typedef void (*SetupTracedCallback)(uint32_t teid, uint64_t dpId,
+                                      Time latency);
+
+  /**
+   * TracedCallback signature for rule benchmark trace source.
+   * \param rules The number of rules built through each path.
+   * \param dpctlRate The dpctl string path rate (rules/sec).
+   * \param binaryRate The binary builder path rate (rules/sec).
+   */
+  typedef void (*BenchmarkTracedCallback)(uint32_t rules, double dpctlRate,
+                                          double binaryRate);
+
 protected:
   // Inherited from Object.
   virtual void DoDispose ();
@@ -110,6 +366,12 @@ protected:
 
   // Inherited from OFSwitch13Controller.
   virtual void HandshakeSuccessful (Ptr<const RemoteSwitch> swtch);
+  virtual ofl_err HandleBarrierReply (
+    struct ofl_msg_header *msg, Ptr<const RemoteSwitch> swtch,
+    uint32_t xid);
+  virtual ofl_err HandlePacketIn (
+    struct ofl_msg_packet_in *msg, Ptr<const RemoteSwitch> swtch,
+    uint32_t xid);
 
 private:
   /**
@@ -127,12 +389,90 @@ private:
    */
   void ControllerTimeout ();
 
+  /**
+   * Update the throughput estimation for traffics on HW and SW switches.
+   */
+  void UpdateTrafficRates ();
+
+  /**
+   * Rebalance traffics between HW and SW switches. Traffics are demoted from
+   * HW to SW when idle or when the HW switch is above the high watermark, and
+   * promoted from SW to HW according to the offload strategy.
+   */
+  void RebalanceSwitches ();
+
+  /**
+   * Sample the CPU usage of HW and SW switches into the load estimators.
+   */
+  void SampleSwitchLoad ();
+
+  /**
+   * Get the switch CPU usage for admission control, according to the
+   * configured load estimator.
+   * \param switchDevice The OpenFlow switch device.
+   * \return The estimated CPU usage.
+   */
+  double GetSwitchLoad (Ptr<OFSwitch13Device> switchDevice);
+
+  /**
+   * Schedule an immediate rebalance in response to a switch overload,
+   * respecting the minimum interval between consecutive rebalances.
+   */
+  void TriggerRebalance ();
+
+  /**
+   * Update traffic rates and rebalance HW and SW switches after an overload.
+   */
+  void OverloadRebalance ();
+
+  /**
+   * Check if the switch usage is above its overload threshold.
+   * \param switchDevice The OpenFlow switch device.
+   * \return True if the switch is overloaded, false otherwise.
+   */
+  bool IsOverloaded (Ptr<OFSwitch13Device> switchDevice) const;
+
+  /**
+   * Trace sink fired on each datapath timeout at HW and SW switches.
+   * \param context The switch name (Hw or Sw).
+   * \param device The OpenFlow switch device.
+   */
+  void NotifyDatapathTimeout (std::string context,
+                              Ptr<const OFSwitch13Device> device);
+
+  /**
+   * Trace sink fired when a packet is dropped by overload at HW and SW
+   * switches.
+   * \param context The switch name (Hw or Sw).
+   * \param packet The dropped packet.
+   */
+  void NotifyOverloadDrop (std::string context, Ptr<const Packet> packet);
+
+  /**
+   * Get the HW or SW switch device from the trace context.
+   * \param context The switch name (Hw or Sw).
+   * \return The OpenFlow switch device.
+   */
+  Ptr<OFSwitch13Device> GetSwitchDevice (std::string context) const;
+
+  /**
+   * Read the counters of the traffic entries in the OpenFlow switch table,
+   * identifying each traffic by the entry cookie and updating the traffic
+   * index. Entries of traffics served by another switch are ignored.
+   * \param switchDevice The OpenFlow switch device.
+   */
+  void ReadFlowStats (Ptr<OFSwitch13Device> switchDevice);
+
   /**
    * Install traffic rules into OpenFlow switch.
    * \param switchDevice The OpenFlow switch for this traffic.
    * \param teid The traffic ID.
+   * \param bufferUl The switch buffer released by the UL rule.
+   * \param bufferDl The switch buffer released by the DL rule.
    */
-  void InstallTrafficRules (Ptr<OFSwitch13Device> switchDevice, uint32_t teid);
+  void InstallTrafficRules (Ptr<OFSwitch13Device> switchDevice, uint32_t teid,
+                            uint32_t bufferUl = OFP_NO_BUFFER,
+                            uint32_t bufferDl = OFP_NO_BUFFER);
 
   /**
    * Remove traffic rules from OpenFlow switch.
@@ -150,12 +490,392 @@ private:
   void MoveTrafficRules (Ptr<OFSwitch13Device> srcSwitchDevice,
                          Ptr<OFSwitch13Device> dstSwitchDevice, uint32_t teid);
 
+  /**
+   * Install the meter for this traffic on HW or SW switch.
+   * \param switchDevice The OpenFlow switch device.
+   * \param bearer The traffic record.
+   */
+  void InstallMeter (Ptr<OFSwitch13Device> switchDevice,
+                     const BearerInfo &bearer);
+
+  /**
+   * Remove the meter for this traffic from HW or SW switch.
+   * \param switchDevice The OpenFlow switch device.
+   * \param teid The traffic ID.
+   */
+  void RemoveMeter (Ptr<OFSwitch13Device> switchDevice, uint32_t teid);
+
+  /**
+   * Get the meter rate for this traffic, from the EPS bearer MBR when
+   * available, or from the expected bitrate of the application otherwise.
+   * \param bearer The traffic record.
+   * \return The meter rate.
+   */
+  DataRate GetMeterRate (const BearerInfo &bearer) const;
+
+  /**
+   * Install the table-miss rule on HW or SW switch, dropping packets in
+   * proactive mode or sending them to the controller in reactive mode. On
+   * the HW switch with split pipeline, this rule goes to the wildcard table.
+   * \param switchDevice The OpenFlow switch device.
+   */
+  void InstallMissRule (Ptr<OFSwitch13Device> switchDevice);
+
+  /**
+   * Build and send the UL/DL rules of fake traffics to the switch through
+   * both the dpctl string and the binary builder paths, timing each one.
+   * The rules are removed afterwards.
+   * \param swtch The remote switch.
+   */
+  void RunRuleBenchmark (Ptr<const RemoteSwitch> swtch);
+
+  /**
+   * Find the traffic for the packet received by the packet-in message.
+   * \param msg The packet-in message.
+   * \param uplink True for packets in the uplink direction.
+   * \return The traffic record or null when not found.
+   */
+  BearerInfo* FindPacketBearer (const struct ofl_msg_packet_in *msg,
+                                bool uplink);
+
   /**
    * Update UL and DL rules when moving traffic.
    * \param teid The traffic ID.
    */
   void UpdateDlUlRules (uint32_t teid);
 
+  /**
+   * Select the switch, check its resources and install the rules for a new
+   * traffic.
+   * \param app The application pointer.
+   * \return True if the traffic was admitted.
+   */
+  bool AdmitBearer (Ptr<SvelteClient> app);
+
+  /**
+   * Hold a rejected request in the admission queue. When the queue is full,
+   * the request with the lowest priority is dropped.
+   * \param app The application pointer.
+   * \return True if the request was queued.
+   */
+  bool EnqueueRequest (Ptr<SvelteClient> app);
+
+  /**
+   * Retry the admission of queued requests, dropping the expired ones.
+   */
+  void ProcessPendingRequests ();
+
+  /**
+   * Parse a traffic class table in the "Class=Value,Class=Value" format.
+   * \param table The table string.
+   * \return The values indexed by traffic class.
+   */
+  static std::map<TrafficClass, std::string> ParseClassTable (
+    const std::string &table);
+
+  /**
+   * Check the HW quota for a new traffic of this class.
+   * \param cls The traffic class.
+   * \return True if the class can use more HW table entries.
+   */
+  bool HasHwQuota (TrafficClass cls);
+
+  /**
+   * Move the traffic to a new HW/SW switch in the traffic index, updating the
+   * switch reservations and the per class traffic counters at the HW switch.
+   * \param bearer The traffic metadata.
+   * \param switchDevice The new switch device (null when removed).
+   */
+  void SetBearerSwitch (BearerInfo &bearer, Ptr<OFSwitch13Device> switchDevice);
+
+  /**
+   * Get the output queue for traffics of this class.
+   * \param cls The traffic class.
+   * \return The queue ID (0 for the default queue).
+   */
+  uint32_t GetClassQueue (TrafficClass cls) const;
+
+  /**
+   * Install the rules on UL or DL switch that select the output queue for
+   * packets coming from HW and SW switches, based on the class DSCP mark.
+   * \param switchDevice The OpenFlow switch device.
+   * \param hwPort The port number on the switch to the HW switch.
+   * \param swPort The port number on the switch to the SW switch.
+   */
+  void InstallQueueRules (Ptr<OFSwitch13Device> switchDevice,
+                          uint32_t hwPort, uint32_t swPort);
+
+  /**
+   * Check the switch resources for admitting a new traffic.
+   * \param switchDevice The OpenFlow switch device.
+   * \param expected The expected traffic rate (bps).
+   * \return True if the switch can accept the traffic.
+   */
+  bool HasResources (Ptr<OFSwitch13Device> switchDevice, uint64_t expected);
+
+  /**
+   * Get the switch resources that must be released before admitting a new
+   * traffic. Non-positive values indicate available resources.
+   * \param switchDevice The OpenFlow switch device.
+   * \param expected The expected traffic rate (bps).
+   * \param entries The table entries above the block threshold.
+   * \param bps The CPU bps above the block threshold.
+   */
+  void GetDeficit (Ptr<OFSwitch13Device> switchDevice, uint64_t expected,
+                   double &entries, double &bps);
+
+  /**
+   * Preempt lower priority bearers from the switch, according to the
+   * allocation and retention priority, to admit a new traffic.
+   * \param switchDevice The OpenFlow switch device.
+   * \param app The application requesting resources.
+   * \param expected The expected traffic rate (bps).
+   * \return True if enough resources were released.
+   */
+  bool PreemptBearers (Ptr<OFSwitch13Device> switchDevice,
+                       Ptr<SvelteClient> app, uint64_t expected);
+
+  /**
+   * Check that a preempted application stopped, which is required to release
+   * its resources.
+   * \param app The preempted application.
+   */
+  void CheckPreempted (Ptr<SvelteClient> app);
+
+  /**
+   * Remove the rules and the record for this traffic.
+   * \param teid The traffic ID.
+   * \return The number of delete messages sent.
+   */
+  uint32_t RemoveBearer (uint32_t teid);
+
+  /**
+   * Create the migration group for this traffic at UL and DL switches, if
+   * not created yet. The group forwards all client traffics to the switch
+   * currently serving them.
+   * \param switchDevice The switch initially serving the group.
+   * \param bearer The traffic record.
+   */
+  void InstallGroupRules (Ptr<OFSwitch13Device> switchDevice,
+                          const BearerInfo &bearer);
+
+  /**
+   * Move all traffics in a migration group from one switch to the other.
+   * \param srcSwitchDevice The source switch device.
+   * \param dstSwitchDevice The target switch device.
+   * \param group The group ID.
+   * \param teids The traffics in this group.
+   */
+  void MoveGroupRules (Ptr<OFSwitch13Device> srcSwitchDevice,
+                       Ptr<OFSwitch13Device> dstSwitchDevice, uint32_t group,
+                       const std::vector<uint32_t> &teids);
+
+  /**
+   * Update the group output port at UL and DL switches when moving a group.
+   * \param group The group ID.
+   */
+  void UpdateGroupRules (uint32_t group);
+
+  /**
+   * Remove the rules of all traffics in a group from a switch.
+   * \param switchDevice The switch device.
+   * \param group The group ID.
+   */
+  void RemoveGroupRules (Ptr<OFSwitch13Device> switchDevice, uint32_t group);
+
+  /**
+   * Set the match fields that identify the uplink and downlink packets of
+   * this traffic, including the TEID in the cookie field.
+   * \param ruleUl The uplink rule builder.
+   * \param ruleDl The downlink rule builder.
+   * \param bearer The traffic record.
+   */
+  void SetTrafficMatch (FlowModBuilder &ruleUl, FlowModBuilder &ruleDl,
+                        const BearerInfo &bearer);
+
+  /**
+   * Get the expected bitrate for this traffic, adding up both directions,
+   * derived from the application traffic model identified by the TEID.
+   * \param teid The traffic ID.
+   * \return The expected bitrate.
+   */
+  static DataRate GetExpectedRate (uint32_t teid);
+
+  /**
+   * Get the expected end time for the traffic of this application, assuming
+   * it starts in +1 second as scheduled by the TrafficManager.
+   * \param app The application pointer.
+   * \return The expected end time.
+   */
+  static Time GetExpectedEnd (Ptr<SvelteClient> app);
+
+  /**
+   * Queue the OpenFlow message to the switch. Messages to the same switch are
+   * coalesced within the batch window and sent in a single burst. When the
+   * OpenFlow connection is not established yet, the messages are kept and
+   * sent after the handshake. This function takes the ownership of the
+   * message.
+   * \param switchDevice The OpenFlow switch device.
+   * \param msg The OpenFlow message.
+   */
+  void SendRule (Ptr<OFSwitch13Device> switchDevice,
+                 struct ofl_msg_header *msg);
+
+  /**
+   * Send the queued OpenFlow messages to the switch, followed by a barrier.
+   * \param dpId The switch datapath ID.
+   */
+  void FlushRules (uint64_t dpId);
+
+  /**
+   * Schedule the flush of queued messages to the switch, if connected.
+   * \param dpId The switch datapath ID.
+   */
+  void ScheduleFlush (uint64_t dpId);
+
+  /**
+   * Advance the migration when the switch confirms all messages queued so
+   * far, through the barrier reply of the next burst.
+   * \param switchDevice The OpenFlow switch device.
+   * \param migration The migration ID.
+   */
+  void WaitConfirmation (Ptr<OFSwitch13Device> switchDevice,
+                         uint32_t migration);
+
+  /**
+   * Start a new migration between HW and SW switches, after the rules were
+   * queued to the target switch.
+   * \param id The traffic ID or group ID.
+   * \param group True for group migration.
+   * \param srcSwitchDevice The source switch device.
+   * \param dstSwitchDevice The target switch device.
+   */
+  void StartMigration (uint32_t id, bool group,
+                       Ptr<OFSwitch13Device> srcSwitchDevice,
+                       Ptr<OFSwitch13Device> dstSwitchDevice);
+
+  /**
+   * Move the migration to its next stage once all pending confirmations
+   * arrived: redirect UL and DL switches, remove rules from the source
+   * switch, and finish.
+   * \param migration The migration ID.
+   */
+  void AdvanceMigration (uint32_t migration);
+
+  /**
+   * Remove the rules from the source switch after the drain interval.
+   * \param migration The migration ID.
+   */
+  void DrainMigration (uint32_t migration);
+
+  /**
+   * Get the number of packets that missed all rules at the switch, counted by
+   * the table-miss entry (at the wildcard table on the split HW pipeline).
+   * This counter is switch-wide, not per traffic.
+   * \param switchDevice The OpenFlow switch device.
+   * \return The number of table-miss packets.
+   */
+  uint64_t GetTableMisses (Ptr<OFSwitch13Device> switchDevice) const;
+
+  /** Fila de mensagens OpenFlow para um switch. */
+  struct RuleBatch
+  {
+    RuleBatch () : queued (0), freed (false) {}
+    std::list<struct ofl_msg_header*> msgs;       //!< Mensagens na fila.
+    uint32_t                          queued;     //!< Total enfileirado.
+    bool                              freed;      //!< Remoções de liberação.
+    EventId                           flushEvent; //!< Evento de envio.
+    std::vector<uint32_t>             waiting;    //!< Migrações aguardando.
+    std::vector<std::pair<uint32_t, Time> > setups; //!< Instalações reativas.
+  };
+
+  /** Etapas de uma migração. */
+  enum MigrationStage
+  {
+    INSTALL  = 0,   //!< Instalando regras no switch de destino.
+    REDIRECT = 1,   //!< Redirecionando os switches UL e DL.
+    DRAIN    = 2,   //!< Aguardando os pacotes em trânsito.
+    REMOVE   = 3    //!< Removendo regras do switch de origem.
+  };
+
+  /** Migração de um tráfego ou grupo entre os switches HW e SW. */
+  struct Migration
+  {
+    uint32_t                          id;         //!< TEID ou grupo.
+    bool                              group;      //!< Migração de grupo.
+    Ptr<OFSwitch13Device>             srcSwitch;  //!< Switch de origem.
+    Ptr<OFSwitch13Device>             dstSwitch;  //!< Switch de destino.
+    MigrationStage                    stage;      //!< Etapa atual.
+    uint32_t                          pending;    //!< Confirmações pendentes.
+    Time                              start;      //!< Início da migração.
+    uint64_t                          missBase;   //!< Perdas no início.
+  };
+
+  /** Grupo de migração nos switches UL e DL. */
+  struct GroupInfo
+  {
+    Ptr<OFSwitch13Device>             switchDevice; //!< Switch HW/SW atual.
+    Time                              lastMove;     //!< Última mudança.
+  };
+
+  /** Unidade movida entre os switches HW e SW (tráfego ou grupo). */
+  struct MoveUnit
+  {
+    uint32_t                          id;         //!< TEID ou grupo.
+    Ptr<OFSwitch13Device>             switchDevice; //!< Switch HW/SW atual.
+    uint64_t                          bps;        //!< Vazão estimada.
+    double                            remBytes;   //!< Bytes restantes.
+    uint32_t                          entries;    //!< Entradas de tabela.
+    double                            heat;       //!< Atividade no cache.
+    bool                              ready;      //!< Pode ser movida.
+    std::vector<uint32_t>             teids;      //!< Tráfegos da unidade.
+  };
+
+  /**
+   * Move a traffic or group between HW and SW switches.
+   * \param unit The move unit.
+   * \param dstSwitchDevice The target switch device.
+   */
+  void MoveUnitRules (const MoveUnit &unit,
+                      Ptr<OFSwitch13Device> dstSwitchDevice);
+
+  /**
+   * Manage the HW switch table as a cache of the traffics on the SW switch.
+   * The hottest SW units are promoted, evicting colder HW units when the HW
+   * switch has no room for them.
+   * \param hwUnits The units on the HW switch.
+   * \param swUnits The units on the SW switch.
+   * \param tabHwUsed The expected HW table usage (entries).
+   * \param bpsHwUsed The expected HW CPU usage (bps).
+   * \param tabSwUsed The expected SW table usage (entries).
+   * \param bpsSwUsed The expected SW CPU usage (bps).
+   * \param stats The rebalance statistics.
+   */
+  void UpdateHwCache (const std::vector<MoveUnit*> &hwUnits,
+                      const std::vector<MoveUnit*> &swUnits,
+                      double &tabHwUsed, double &bpsHwUsed,
+                      double &tabSwUsed, double &bpsSwUsed,
+                      RebalanceStats &stats);
+
+  /** Requisição aguardando na fila de admissão. */
+  struct PendingRequest
+  {
+    Ptr<SvelteClient>                 app;        //!< Aplicação.
+    Time                              arrival;    //!< Chegada na fila.
+    Time                              deadline;   //!< Espera máxima.
+  };
+
+  /** Intervalo de sobrecarga em um switch. */
+  struct OverloadInfo
+  {
+    OverloadInfo () : active (false), drops (0), lastDrops (0), rebalances (0) {}
+    bool                              active;     //!< Sobrecarga em curso.
+    Time                              onset;      //!< Início da sobrecarga.
+    uint32_t                          drops;      //!< Descartes no intervalo.
+    uint32_t                          lastDrops;  //!< Descartes na última checagem.
+    uint32_t                          rebalances; //!< Rebalanceamentos.
+  };
+
   Ptr<OFSwitch13Device>           switchDeviceUl; //!< UL switch device.
   Ptr<OFSwitch13Device>           switchDeviceDl; //!< DL switch device.
   Ptr<OFSwitch13Device>           switchDeviceHw; //!< HW switch device.
@@ -172,12 +892,122 @@ private:
 
   double                          m_blockThs;     //!< Threshold de bloqueio.
   bool                            m_blockPol;     //!< Política de bloqueio.
+  bool                            m_overflow;     //!< Política de transbordo.
+  bool                            m_preemption;   //!< Preempção por ARP.
+  Time                            m_preemptTimeout; //!< Limite para parada.
+  uint8_t                         m_hwAggTable;   //!< Tabela agregada no HW.
+  InstallMode                     m_install;      //!< Modo de instalação.
+  uint16_t                        m_missLen;      //!< Bytes no packet-in.
+  uint32_t                        m_ruleBench;    //!< Tráfegos no benchmark.
+  MeterPolicy                     m_meterPol;     //!< Política de medidores.
+  double                          m_meterFactor;  //!< Folga dos medidores.
+  PlacementPolicy                 m_placement;    //!< Política de alocação.
+  std::string                     m_classPref;    //!< Preferência por classe.
+  std::string                     m_classQuota;   //!< Cota no HW por classe.
+  std::map<TrafficClass, bool>    m_classHw;      //!< Classes preferindo o HW.
+  std::map<TrafficClass, double>  m_hwQuota;      //!< Cotas no HW.
+  std::map<TrafficClass, uint32_t> m_hwClassBearers; //!< Tráfegos no HW.
+  std::string                     m_classQueue;   //!< Fila por classe.
+  std::map<TrafficClass, uint32_t> m_queues;      //!< Filas de saída.
+  uint32_t                        m_queueSize;    //!< Tamanho da fila.
+  Time                            m_maxWait;      //!< Espera máxima na fila.
   bool                            m_qosRoute;     //!< Politica de roteamento.
   Time                            m_timeout;      //!< Timeout do controlador.
-  std::map<uint32_t, Ipv4Address> m_teidAddr;     //!< Mapa TEID / IP cliente.
+  Time                            m_batchWindow;  //!< Janela de agrupamento.
+  OffloadPlanner::Strategy        m_offStrategy;  //!< Estratégia de offload.
+  bool                            m_offCompare;   //!< Comparar estratégias.
+  OffloadValue                    m_offValue;     //!< Valor dos candidatos.
+  CachePolicy                     m_cachePol;     //!< Política de cache.
+  uint64_t                        m_hwBytes;      //!< Bytes no switch HW.
+  uint64_t                        m_swBytes;      //!< Bytes no switch SW.
+  uint64_t                        m_hwPkts;       //!< Pacotes no switch HW.
+  uint64_t                        m_swPkts;       //!< Pacotes no switch SW.
+  uint32_t                        m_exactLimit;   //!< Limite do modo exato.
+  RateEstimator::Mode             m_rateMode;     //!< Estimador de vazão.
+  double                          m_ewmaAlpha;    //!< Peso do EWMA.
+  Time                            m_rateWindow;   //!< Janela deslizante.
+  double                          m_highMark;     //!< Marca superior no HW.
+  double                          m_lowMark;      //!< Marca inferior no HW.
+  Time                            m_minResidence; //!< Permanência mínima.
+  DataRate                        m_idleRate;     //!< Vazão de ociosidade.
+  bool                            m_eventRebal;   //!< Rebalanceamento por evento.
+  MigrationMode                   m_migMode;      //!< Modo de migração.
+  AdmissionMode                   m_admMode;      //!< Modo de admissão.
+  LoadEstimator::View             m_loadView;     //!< Estimador de carga.
+  Time                            m_loadSampling; //!< Intervalo de amostragem.
+  double                          m_loadAlpha;    //!< Peso do EWMA de carga.
+  Time                            m_loadWindow;   //!< Janela de carga.
+  double                          m_loadPct;      //!< Percentil de carga.
+  Time                            m_drainTime;    //!< Tempo de escoamento.
+  uint32_t                        m_barrierXid;   //!< Último xid de barreira.
+  uint32_t                        m_migrationId;  //!< Último ID de migração.
+  Time                            m_rebalGap;     //!< Intervalo entre rebalanceamentos.
+  Time                            m_lastRebal;    //!< Último rebalanceamento.
+  EventId                         m_rebalEvent;   //!< Rebalanceamento agendado.
+  std::map<uint64_t, RuleBatch>   m_ruleBatches;  //!< Filas por switch.
+
+  BearerTable                     m_bearers;      //!< Índice de tráfegos.
+  std::set<uint64_t>              m_connected;    //!< Switches conectados.
+  std::map<uint64_t, OverloadInfo> m_overloads;   //!< Sobrecargas por switch.
+  std::map<uint32_t, GroupInfo>   m_groups;       //!< Grupos de migração.
+  std::map<uint64_t, uint64_t>    m_reserved;     //!< Reservas por switch.
+  std::map<uint64_t, LoadEstimator> m_loadEst;    //!< Carga por switch.
+  std::map<uint32_t, Migration>   m_migrations;   //!< Migrações em curso.
+  std::map<uint32_t, EventId>     m_preempted;    //!< Tráfegos preemptados.
+
+  /** Fila de admissão, ordenada pela vazão esperada. */
+  std::multimap<uint64_t, PendingRequest> m_pending;
+
+  /** Migrações aguardando a resposta de barreira (switch, xid). */
+  std::map<std::pair<uint64_t, uint32_t>, std::vector<uint32_t> > m_barriers;
+
+  /** Instalações reativas aguardando a resposta de barreira (switch, xid). */
+  std::map<std::pair<uint64_t, uint32_t>,
+           std::vector<std::pair<uint32_t, Time> > > m_setups;
+
+  /** Remoções de liberações aguardando a resposta de barreira (switch, xid). */
+  std::set<std::pair<uint64_t, uint32_t> > m_releases;
+
+  /** Medidores instalados nos switches (switch, teid). */
+  std::set<std::pair<uint64_t, uint32_t> > m_meters;
 
   TracedCallback<uint32_t, bool>  m_requestTrace; //!< Request trace source.
   TracedCallback<uint32_t>        m_releaseTrace; //!< Release trace source.
+  TracedCallback<uint32_t, uint32_t, uint32_t> m_deleteTrace; //!< Delete trace.
+  TracedCallback<uint64_t, uint32_t, uint32_t> m_batchTrace; //!< Batch trace.
+
+  /** Offload plan trace source. */
+  TracedCallback<std::string, bool, bool, uint32_t, double, double> m_offloadTrace;
+
+  /** Rebalance trace source. */
+  TracedCallback<const RebalanceStats&> m_rebalanceTrace;
+
+  /** Overload trace source. */
+  TracedCallback<uint64_t, Time, uint32_t, uint32_t> m_overloadTrace;
+
+  /** Migration trace source. */
+  TracedCallback<uint32_t, bool, Time, uint64_t> m_migrationTrace;
+
+  /** Switch load trace source. */
+  TracedCallback<uint64_t, double, double, double, double> m_loadTrace;
+
+  /** Overflow trace source. */
+  TracedCallback<uint32_t, uint64_t> m_overflowTrace;
+
+  /** Preemption trace source. */
+  TracedCallback<uint32_t, uint32_t> m_preemptTrace;
+
+  /** Admission queue trace source. */
+  TracedCallback<uint32_t, Time, bool> m_waitTrace;
+
+  /** Packet-in trace source. */
+  TracedCallback<uint64_t, uint32_t, bool> m_packetInTrace;
+
+  /** Reactive rule setup trace source. */
+  TracedCallback<uint32_t, uint64_t, Time> m_setupTrace;
+
+  /** Rule benchmark trace source. */
+  TracedCallback<uint32_t, double, double> m_benchTrace;
 };
 
 } // namespace ns3
@@ -0,0 +1,110 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Campinas (Unicamp)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Rafael G. Motta <rafaelgmotta@gmail.com>
+ *         Luciano J. Chaves <ljerezchaves@gmail.com>
+ */
+
+#include "load-estimator.h"
+#include <algorithm>
+#include <vector>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LoadEstimator");
+
+LoadEstimator::LoadEstimator ()
+  : m_alpha (0.2),
+  m_percentile (0.95),
+  m_last (0),
+  m_ewma (0),
+  m_first (true)
+{
+}
+
+void
+LoadEstimator::Configure (double alpha, Time window, double percentile)
+{
+  NS_LOG_FUNCTION (this << alpha << window << percentile);
+
+  m_alpha = alpha;
+  m_window = window;
+  m_percentile = percentile;
+  m_last = 0;
+  m_ewma = 0;
+  m_first = true;
+  m_samples.clear ();
+}
+
+void
+LoadEstimator::Update (double usage, Time now)
+{
+  NS_LOG_FUNCTION (this << usage << now);
+
+  // The first sample initializes the average.
+  m_ewma = m_first ? usage : m_alpha * usage + (1 - m_alpha) * m_ewma;
+  m_first = false;
+  m_last = usage;
+
+  // Discard the samples out of the window, but always keep the newest.
+  m_samples.push_back (std::make_pair (now, usage));
+  while (m_samples.size () > 1 && m_samples.front ().first < now - m_window)
+    {
+      m_samples.pop_front ();
+    }
+}
+
+double
+LoadEstimator::Get (View view) const
+{
+  switch (view)
+    {
+    case LoadEstimator::EWMA:
+      return m_ewma;
+    case LoadEstimator::PEAK:
+      {
+        double peak = 0;
+        for (auto const &sample : m_samples)
+          {
+            peak = std::max (peak, sample.second);
+          }
+        return peak;
+      }
+    case LoadEstimator::PERCENTILE:
+      {
+        if (m_samples.empty ())
+          {
+            return 0;
+          }
+        std::vector<double> values;
+        values.reserve (m_samples.size ());
+        for (auto const &sample : m_samples)
+          {
+            values.push_back (sample.second);
+          }
+        size_t idx = std::min (values.size () - 1, static_cast<size_t> (
+                                 m_percentile * values.size ()));
+        std::nth_element (values.begin (), values.begin () + idx, values.end ());
+        return values [idx];
+      }
+    case LoadEstimator::INSTANT:
+    default:
+      return m_last;
+    }
+}
+
+} // namespace ns3
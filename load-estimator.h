@@ -0,0 +1,83 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Campinas (Unicamp)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Rafael G. Motta <rafaelgmotta@gmail.com>
+ *         Luciano J. Chaves <ljerezchaves@gmail.com>
+ */
+
+#ifndef LOAD_ESTIMATOR_H
+#define LOAD_ESTIMATOR_H
+
+#include <ns3/core-module.h>
+#include <deque>
+
+namespace ns3 {
+
+/**
+ * This helper smooths the switch CPU usage samples, keeping the EWMA, the
+ * peak and a percentile over a sliding time window.
+ */
+class LoadEstimator
+{
+public:
+  /** Estimation view. */
+  enum View
+  {
+    INSTANT    = 0, //!< Last sample.
+    EWMA       = 1, //!< Exponentially weighted moving average.
+    PEAK       = 2, //!< Maximum sample within the window.
+    PERCENTILE = 3  //!< Percentile of samples within the window.
+  };
+
+  LoadEstimator ();   //!< Default constructor.
+
+  /**
+   * Configure the estimator and reset its internal state.
+   * \param alpha The EWMA weight for the newest sample.
+   * \param window The sliding window length.
+   * \param percentile The percentile in the [0, 1] interval.
+   */
+  void Configure (double alpha, Time window, double percentile);
+
+  /**
+   * Feed the estimator with a new sample.
+   * \param usage The CPU usage sample.
+   * \param now The current time.
+   */
+  void Update (double usage, Time now);
+
+  /**
+   * Get the current estimation for the given view.
+   * \param view The estimation view.
+   * \return The estimated CPU usage.
+   */
+  double Get (View view) const;
+
+private:
+  double    m_alpha;        //!< EWMA weight.
+  Time      m_window;       //!< Sliding window length.
+  double    m_percentile;   //!< Percentile.
+  double    m_last;         //!< Last sample.
+  double    m_ewma;         //!< EWMA estimation.
+  bool      m_first;        //!< No samples yet.
+
+  /** Samples within the sliding window (time, usage). */
+  std::deque<std::pair<Time, double> > m_samples;
+};
+
+} // namespace ns3
+#endif  // LOAD_ESTIMATOR_H
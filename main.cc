@@ -19,6 +19,9 @@
  *         Luciano J. Chaves <ljerezchaves@gmail.com>
  */
 
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <ns3/config-store-module.h>
@@ -50,12 +53,40 @@ static ns3::GlobalValue
 static ns3::GlobalValue
   g_numHosts ("NumHosts", "Number of client hosts.",
               ns3::UintegerValue (1),
-              ns3::MakeUintegerChecker<uint16_t> ());
+              ns3::MakeUintegerChecker<uint32_t> ());
+
+// Size of the exact-match table for bearer rules on the HW switch.
+static ns3::GlobalValue
+  g_hwExactTable ("HwExactTable",
+                  "HW exact-match table size (0 for a single TCAM table).",
+                  ns3::UintegerValue (0),
+                  ns3::MakeUintegerChecker<uint32_t> ());
+
+// Number of clients sharing each access port on the UL switch.
+static ns3::GlobalValue
+  g_hostsPerPort ("HostsPerPort",
+                  "Clients per access port (0 for one port per client).",
+                  ns3::UintegerValue (0),
+                  ns3::MakeUintegerChecker<uint32_t> ());
+
+// Number of clients per access switch uplinked to the UL switch.
+static ns3::GlobalValue
+  g_hostsPerAccess ("HostsPerAccess",
+                    "Clients per access switch (0 to connect them to UL).",
+                    ns3::UintegerValue (0),
+                    ns3::MakeUintegerChecker<uint32_t> ());
 
 void ForceDefaults  ();
 void EnableProgress (uint32_t);
 void EnableVerbose  (bool);
 void EnableOfsLogs  (bool);
+void PrintUsage     (std::string, double);
+void PrintRuleBenchmark (uint32_t, double, double);
+uint32_t GetBlockSize (uint32_t);
+void ConnectClients (Ptr<CustomController>, CsmaHelper&, Ipv4AddressHelper&,
+                     Ptr<Node>, Ptr<OFSwitch13Device>, bool, NodeContainer,
+                     uint32_t, uint32_t, NetDeviceContainer&,
+                     Ipv4InterfaceContainer&);
 
 int
 main (int argc, char *argv[])
@@ -113,6 +144,7 @@ main (int argc, char *argv[])
 
   // Create the simulation scenario.
   NS_LOG_INFO ("Creating simulation scenario...");
+  auto buildStart = std::chrono::steady_clock::now ();
 
   // Configure the CsmaHelper to connect OpenFlow switches (2KM Fiber cable)
   CsmaHelper csmaHelper;
@@ -129,6 +161,8 @@ main (int argc, char *argv[])
   Names::Add ("ct", controllerNode);
   Ptr<CustomController> controllerApp = CreateObject<CustomController> ();
   of13Helper->InstallController (controllerNode, controllerApp);
+  controllerApp->TraceConnectWithoutContext (
+    "RuleBenchmark", MakeCallback (&PrintRuleBenchmark));
 
   // Create and name the switch nodes.
   NodeContainer switchNodes;
@@ -150,12 +184,25 @@ main (int argc, char *argv[])
   Ptr<OFSwitch13Device> switchDeviceUl = of13Helper->InstallSwitch (switchNodeUl);
   Ptr<OFSwitch13Device> switchDeviceDl = of13Helper->InstallSwitch (switchNodeDl);
 
-  // Configure switch node HW as a hardware-based OpenFlow switch.
-  of13Helper->SetDeviceAttribute ("PipelineTables", UintegerValue (1));
+  // Configure switch node HW as a hardware-based OpenFlow switch. With the
+  // split pipeline, table 0 is a large exact-match table for bearer rules and
+  // table 1 is the small TCAM table for wildcard rules.
+  UintegerValue exactValue;
+  GlobalValue::GetValueByName ("HwExactTable", exactValue);
+  uint32_t hwExactTable = exactValue.Get ();
+  uint32_t hwTcamTable = 1024;
+  of13Helper->SetDeviceAttribute ("PipelineTables", UintegerValue (hwExactTable ? 2 : 1));
   of13Helper->SetDeviceAttribute ("CpuCapacity", StringValue ("2Gbps"));
-  of13Helper->SetDeviceAttribute ("FlowTableSize", UintegerValue (1024));
+  of13Helper->SetDeviceAttribute ("FlowTableSize", UintegerValue (hwExactTable ? hwExactTable : hwTcamTable));
   of13Helper->SetDeviceAttribute ("TcamDelay", TimeValue (MicroSeconds (20)));
   Ptr<OFSwitch13Device> switchDeviceHw = of13Helper->InstallSwitch (switchNodeHw);
+  if (hwExactTable)
+    {
+      // The FlowTableSize attribute sets the same size for all pipeline
+      // tables, so the TCAM table is resized right after the installation.
+      struct datapath *datapath = switchDeviceHw->GetDatapathStruct ();
+      datapath->pipeline->tables [1]->features->max_entries = hwTcamTable;
+    }
 
   // Configure switch node SW as a software-based OpenFlow switch.
   of13Helper->SetDeviceAttribute ("PipelineTables", UintegerValue (1));
@@ -182,7 +229,7 @@ main (int argc, char *argv[])
   uint32_t dl2swPort = switchDeviceDl->AddSwitchPort (sw2dlLink.Get (1))->GetPortNo ();
 
   // Notify the controller about switches (don't change the order!)
-  controllerApp->NotifyHwSwitch (switchDeviceHw, hw2ulPort, hw2dlPort);
+  controllerApp->NotifyHwSwitch (switchDeviceHw, hw2ulPort, hw2dlPort, hwExactTable);
   controllerApp->NotifySwSwitch (switchDeviceSw, sw2ulPort, sw2dlPort);
 
   controllerApp->NotifyUlSwitch (switchDeviceUl, ul2hwPort, ul2swPort);
@@ -227,20 +274,84 @@ main (int argc, char *argv[])
   Ipv4InterfaceContainer serverIpIface = ipv4helpr.Assign (serverDevice);
   controllerApp->NotifyDl2Sv (dl2svPort, serverIpIface.GetAddress (0));
 
+  // The traffic helper adds more server addresses from a separate network
+  // when the applications exceed the port space of a single address.
+  Ipv4Mask serverMask;
+  Ipv4Address serverNet = TrafficHelper::GetServerNetwork (serverMask);
+  controllerApp->NotifyDl2Sv (dl2svPort, serverNet, serverMask);
+
+  // Get the number of clients per access port and per access switch.
+  GlobalValue::GetValueByName ("HostsPerPort", uintegerValue);
+  uint32_t hostsPerPort = uintegerValue.Get ();
+  GlobalValue::GetValueByName ("HostsPerAccess", uintegerValue);
+  uint32_t hostsPerAccess = uintegerValue.Get ();
+
   NetDeviceContainer clientDevices;
   Ipv4InterfaceContainer clientIpIfaces;
-  for (uint32_t i = 0; i < numHosts; i++)
+  if (hostsPerAccess == 0)
     {
-      // Connect each client node to the UL switch.
-      NetDeviceContainer ul2clLink = csmaHelper.Install (switchNodeUl, clientNodes.Get (i));
-      uint32_t ul2clPort = switchDeviceUl->AddSwitchPort (ul2clLink.Get (0))->GetPortNo ();
-      clientDevices.Add (ul2clLink.Get (1));
-
-      // Assign IP to the client node and notify the controller.
-      Ipv4InterfaceContainer tempIpIface = ipv4helpr.Assign (ul2clLink.Get (1));
-      clientIpIfaces.Add (tempIpIface);
-      controllerApp->NotifyUl2Cl (ul2clPort, tempIpIface.GetAddress (0));
+      // Connect the client nodes straight to the UL switch. Without shared
+      // access ports, addresses follow the server one.
+      uint32_t firstAddr = hostsPerPort ? GetBlockSize (hostsPerPort) : 2;
+      ConnectClients (controllerApp, csmaHelper, ipv4helpr, switchNodeUl,
+                      switchDeviceUl, false, clientNodes, hostsPerPort,
+                      firstAddr, clientDevices, clientIpIfaces);
     }
+  else
+    {
+      // Each access switch gets an aligned address block that holds all its
+      // clients (and their access port blocks), so the UL switch needs a
+      // single prefix rule per access switch. The first block holds the
+      // server.
+      uint32_t portHosts = hostsPerPort ? hostsPerPort : 1;
+      uint32_t portBlock = hostsPerPort ? GetBlockSize (hostsPerPort) : 1;
+      uint32_t numPorts = (hostsPerAccess + portHosts - 1) / portHosts;
+      uint32_t accBlock = GetBlockSize (numPorts * portBlock);
+      Ipv4Mask accMask (~(accBlock - 1));
+
+      // Configure access switch nodes as standard OpenFlow switches.
+      of13Helper->SetDeviceAttribute ("PipelineTables", UintegerValue (2));
+      of13Helper->SetDeviceAttribute ("CpuCapacity", StringValue ("100Gbps"));
+      of13Helper->SetDeviceAttribute ("FlowTableSize", UintegerValue (65535));
+      of13Helper->SetDeviceAttribute ("TcamDelay", TimeValue (MicroSeconds (20)));
+
+      uint32_t block = 1;
+      for (uint32_t first = 0; first < numHosts; first += hostsPerAccess, block++)
+        {
+          Ptr<Node> switchNodeAc = CreateObject<Node> ();
+          std::ostringstream name;
+          name << "ac" << block;
+          Names::Add (name.str (), switchNodeAc);
+          switchNodes.Add (switchNodeAc);
+          Ptr<OFSwitch13Device> switchDeviceAc = of13Helper->InstallSwitch (switchNodeAc);
+
+          // Connect the access switch to the UL switch.
+          NetDeviceContainer ac2ulLink = csmaHelper.Install (switchNodeAc, switchNodeUl);
+          uint32_t ac2ulPort = switchDeviceAc->AddSwitchPort (ac2ulLink.Get (0))->GetPortNo ();
+          uint32_t ul2acPort = switchDeviceUl->AddSwitchPort (ac2ulLink.Get (1))->GetPortNo ();
+          Ipv4Address prefix (Ipv4Address ("10.0.0.0").Get () + block * accBlock);
+          controllerApp->NotifyAccessSwitch (switchDeviceAc, ac2ulPort, ul2acPort,
+                                             prefix, accMask);
+
+          // Connect the client nodes to the access switch.
+          NodeContainer accessClients;
+          for (uint32_t i = first; i < std::min (numHosts, first + hostsPerAccess); i++)
+            {
+              accessClients.Add (clientNodes.Get (i));
+            }
+          ConnectClients (controllerApp, csmaHelper, ipv4helpr, switchNodeAc,
+                          switchDeviceAc, true, accessClients,
+                          hostsPerPort, block * accBlock, clientDevices,
+                          clientIpIfaces);
+        }
+      NS_LOG_INFO ("Number of access switches set to " << block - 1);
+    }
+
+  // Client address blocks must stay below the additional server addresses.
+  Ipv4Address lastAddr = clientIpIfaces.GetAddress (clientIpIfaces.GetN () - 1);
+  NS_ABORT_MSG_IF (lastAddr.Get () >= serverNet.Get (),
+                   "Client addresses reach the server network " << serverNet <<
+                   ". Reduce NumHosts or the address block sizes.");
 
   // Configure the OpenFlow channel and notify the controller that we are done.
   of13Helper->CreateOpenFlowChannels ();
@@ -277,12 +388,19 @@ main (int argc, char *argv[])
   // Anyway, I've decided to use this to simplify the controller logic.
   Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
   ArpCache::PopulateArpCaches ();
+  std::chrono::duration<double> buildTime =
+    std::chrono::steady_clock::now () - buildStart;
+  PrintUsage ("Topology built", buildTime.count ());
 
   // Run the simulation.
   std::cout << "Simulating..." << std::endl;
   EnableProgress (progress);
   Simulator::Stop (Seconds (simTime + 1));
+  auto runStart = std::chrono::steady_clock::now ();
   Simulator::Run ();
+  std::chrono::duration<double> runTime =
+    std::chrono::steady_clock::now () - runStart;
+  PrintUsage ("Simulation done", runTime.count ());
   Simulator::Destroy ();
   std::cout << "END OK" << std::endl;
 }
@@ -412,4 +530,125 @@ EnableOfsLogs (bool enable)
       std::string prefix = stringValue.Get ();
       ofs::EnableLibraryLog (true, prefix);
     }
-}
\ No newline at end of file
+}
+
+void
+PrintUsage (std::string stage, double wallTime)
+{
+  // Peak resident memory of this process (in KiB on Linux).
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+
+  UintegerValue uintegerValue;
+  GlobalValue::GetValueByName ("NumHosts", uintegerValue);
+  uint32_t numHosts = uintegerValue.Get ();
+
+  std::cout << stage << " in " << fixed << setprecision (3) << wallTime << "s"
+            << ", peak memory " << usage.ru_maxrss << " KiB"
+            << " (" << static_cast<double> (usage.ru_maxrss) / numHosts
+            << " KiB per host)";
+  double simTime = Simulator::Now ().GetSeconds ();
+  if (simTime > 0 && wallTime > 0)
+    {
+      std::cout << ", " << simTime / wallTime << " simulated sec per sec";
+    }
+  std::cout << std::endl;
+}
+
+void
+PrintRuleBenchmark (uint32_t rules, double dpctlRate, double binaryRate)
+{
+  std::cout << "Rule benchmark with " << rules << " rules: dpctl "
+            << fixed << setprecision (0) << dpctlRate << " rules/s, binary "
+            << binaryRate << " rules/s (" << setprecision (2)
+            << binaryRate / dpctlRate << "x)" << std::endl;
+}
+
+uint32_t
+GetBlockSize (uint32_t hosts)
+{
+  // Smallest power of two holding the hosts, with at least two addresses so
+  // that the first block only holds the server.
+  uint32_t blockSize = 2;
+  while (blockSize < hosts)
+    {
+      blockSize <<= 1;
+    }
+  return blockSize;
+}
+
+void
+ConnectClients (Ptr<CustomController> controllerApp, CsmaHelper &csmaHelper,
+                Ipv4AddressHelper &ipv4helpr, Ptr<Node> switchNode,
+                Ptr<OFSwitch13Device> switchDevice, bool access,
+                NodeContainer clientNodes,
+                uint32_t hostsPerPort, uint32_t firstAddr,
+                NetDeviceContainer &clientDevices,
+                Ipv4InterfaceContainer &clientIpIfaces)
+{
+  // The switch is either an access switch or the UL switch itself.
+  uint32_t numHosts = clientNodes.GetN ();
+  ipv4helpr.SetBase ("10.0.0.0", "255.0.0.0", Ipv4Address (firstAddr));
+  if (hostsPerPort == 0)
+    {
+      for (uint32_t i = 0; i < numHosts; i++)
+        {
+          // Connect each client node to the switch.
+          NetDeviceContainer sw2clLink = csmaHelper.Install (switchNode, clientNodes.Get (i));
+          uint32_t sw2clPort = switchDevice->AddSwitchPort (sw2clLink.Get (0))->GetPortNo ();
+          clientDevices.Add (sw2clLink.Get (1));
+
+          // Assign IP to the client node and notify the controller.
+          Ipv4InterfaceContainer tempIpIface = ipv4helpr.Assign (sw2clLink.Get (1));
+          clientIpIfaces.Add (tempIpIface);
+          Ipv4Address ipAddr = tempIpIface.GetAddress (0);
+          if (access)
+            {
+              controllerApp->NotifyAc2Cl (switchDevice, sw2clPort, ipAddr);
+            }
+          else
+            {
+              controllerApp->NotifyUl2Cl (sw2clPort, ipAddr);
+            }
+        }
+      return;
+    }
+
+  // Each access port has a shared CSMA segment with its own aligned address
+  // block, so the switch needs a single prefix rule per port instead of one
+  // rule per client. Hosts keep the /8 mask, so the server is still on-link.
+  uint32_t blockSize = GetBlockSize (hostsPerPort);
+  Ipv4Mask blockMask (~(blockSize - 1));
+  uint32_t blockAddr = firstAddr;
+  for (uint32_t first = 0; first < numHosts; first += hostsPerPort)
+    {
+      // Connect a group of client nodes to the same switch port.
+      NodeContainer segmentNodes (switchNode);
+      for (uint32_t i = first; i < std::min (numHosts, first + hostsPerPort); i++)
+        {
+          segmentNodes.Add (clientNodes.Get (i));
+        }
+      NetDeviceContainer sw2clLink = csmaHelper.Install (segmentNodes);
+      uint32_t sw2clPort = switchDevice->AddSwitchPort (sw2clLink.Get (0))->GetPortNo ();
+      NetDeviceContainer segmentDevices;
+      for (uint32_t i = 1; i < sw2clLink.GetN (); i++)
+        {
+          segmentDevices.Add (sw2clLink.Get (i));
+        }
+      clientDevices.Add (segmentDevices);
+
+      // Assign IPs from the port block and notify the controller.
+      Ipv4Address prefix (Ipv4Address ("10.0.0.0").Get () + blockAddr);
+      ipv4helpr.SetBase ("10.0.0.0", "255.0.0.0", Ipv4Address (blockAddr));
+      clientIpIfaces.Add (ipv4helpr.Assign (segmentDevices));
+      if (access)
+        {
+          controllerApp->NotifyAc2Cl (switchDevice, sw2clPort, prefix, blockMask);
+        }
+      else
+        {
+          controllerApp->NotifyUl2Cl (sw2clPort, prefix, blockMask);
+        }
+      blockAddr += blockSize;
+    }
+}
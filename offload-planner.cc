@@ -0,0 +1,190 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Campinas (Unicamp)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Rafael G. Motta <rafaelgmotta@gmail.com>
+ *         Luciano J. Chaves <ljerezchaves@gmail.com>
+ */
+
+#include "offload-planner.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OffloadPlanner");
+
+OffloadPlanner::OffloadPlanner (uint32_t freeEntries, uint64_t freeBps)
+  : m_freeEntries (freeEntries),
+  m_freeBps (freeBps)
+{
+  NS_LOG_FUNCTION (this << freeEntries << freeBps);
+}
+
+void
+OffloadPlanner::AddCandidate (uint32_t teid, double value, uint64_t bps,
+                              uint32_t entries)
+{
+  NS_LOG_FUNCTION (this << teid << value << bps << entries);
+
+  Candidate candidate;
+  candidate.teid = teid;
+  candidate.value = value;
+  candidate.bps = bps;
+  candidate.entries = entries;
+  m_candidates.push_back (candidate);
+}
+
+OffloadPlanner::Plan
+OffloadPlanner::Solve (Strategy strategy, uint32_t exactLimit) const
+{
+  NS_LOG_FUNCTION (this << strategy << exactLimit);
+
+  // Ordering candidates by decreasing value. The stable sort keeps traffics
+  // with the same value, which were silently dropped by the old std::set.
+  std::vector<Candidate> order (m_candidates);
+  std::stable_sort (order.begin (), order.end (),
+                    [] (const Candidate &a, const Candidate &b)
+    {
+      return a.value > b.value;
+    });
+
+  if (strategy == OffloadPlanner::EXACT && order.size () <= exactLimit)
+    {
+      double remValue = 0;
+      for (auto const &candidate : order)
+        {
+          remValue += candidate.value;
+        }
+
+      Plan current, best;
+      current.value = best.value = 0;
+      current.bps = best.bps = 0;
+      current.entries = best.entries = 0;
+      current.fallback = best.fallback = false;
+      Branch (order, 0, current, remValue, best);
+      return best;
+    }
+
+  if (strategy == OffloadPlanner::GREEDY)
+    {
+      return Fill (order, false);
+    }
+
+  // Heuristic: ordering candidates by decreasing value density, considering
+  // the resources normalized by the free amount on the switch.
+  double entriesScale = m_freeEntries ? 1.0 / m_freeEntries : 1.0;
+  double bpsScale = m_freeBps ? 1.0 / m_freeBps : 1.0;
+  auto density = [entriesScale, bpsScale] (const Candidate &c)
+    {
+      double cost = c.entries * entriesScale + c.bps * bpsScale;
+      return cost > 0 ? c.value / cost : c.value;
+    };
+  std::stable_sort (order.begin (), order.end (),
+                    [&density] (const Candidate &a, const Candidate &b)
+    {
+      return density (a) > density (b);
+    });
+  Plan plan = Fill (order, true);
+  plan.fallback = strategy == OffloadPlanner::EXACT;
+  return plan;
+}
+
+std::string
+OffloadPlanner::StrategyStr (Strategy strategy)
+{
+  switch (strategy)
+    {
+    case OffloadPlanner::GREEDY:
+      return "Greedy";
+    case OffloadPlanner::HEURISTIC:
+      return "Heuristic";
+    case OffloadPlanner::EXACT:
+      return "Exact";
+    default:
+      return "-";
+    }
+}
+
+OffloadPlanner::Plan
+OffloadPlanner::Fill (const std::vector<Candidate> &order, bool skip) const
+{
+  NS_LOG_FUNCTION (this << skip);
+
+  Plan plan;
+  plan.value = 0;
+  plan.bps = 0;
+  plan.entries = 0;
+  plan.fallback = false;
+  for (auto const &candidate : order)
+    {
+      if (plan.entries + candidate.entries > m_freeEntries
+          || plan.bps + candidate.bps > m_freeBps)
+        {
+          if (skip)
+            {
+              continue;
+            }
+          break;
+        }
+
+      plan.teids.push_back (candidate.teid);
+      plan.value += candidate.value;
+      plan.bps += candidate.bps;
+      plan.entries += candidate.entries;
+    }
+  return plan;
+}
+
+void
+OffloadPlanner::Branch (const std::vector<Candidate> &order, size_t idx,
+                        Plan &current, double remValue, Plan &best) const
+{
+  if (current.value > best.value)
+    {
+      best = current;
+    }
+
+  // Prune when even taking all remaining candidates can't beat the best.
+  if (idx == order.size () || current.value + remValue <= best.value)
+    {
+      return;
+    }
+
+  const Candidate &candidate = order [idx];
+  remValue -= candidate.value;
+
+  // Branch including this candidate, when it fits.
+  if (current.entries + candidate.entries <= m_freeEntries
+      && current.bps + candidate.bps <= m_freeBps)
+    {
+      current.teids.push_back (candidate.teid);
+      current.value += candidate.value;
+      current.bps += candidate.bps;
+      current.entries += candidate.entries;
+
+      Branch (order, idx + 1, current, remValue, best);
+
+      current.teids.pop_back ();
+      current.value -= candidate.value;
+      current.bps -= candidate.bps;
+      current.entries -= candidate.entries;
+    }
+
+  // Branch excluding this candidate.
+  Branch (order, idx + 1, current, remValue, best);
+}
+
+} // namespace ns3
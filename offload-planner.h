@@ -0,0 +1,126 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Campinas (Unicamp)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Rafael G. Motta <rafaelgmotta@gmail.com>
+ *         Luciano J. Chaves <ljerezchaves@gmail.com>
+ */
+
+#ifndef OFFLOAD_PLANNER_H
+#define OFFLOAD_PLANNER_H
+
+#include <ns3/core-module.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * This helper selects the traffics that should be offloaded to the HW switch.
+ * It solves the two-resource packing problem (table entries and CPU bps)
+ * using one of the available strategies.
+ */
+class OffloadPlanner
+{
+public:
+  /** Offload strategy. */
+  enum Strategy
+  {
+    GREEDY    = 0,  //!< Decreasing value, stop at the first misfit.
+    HEURISTIC = 1,  //!< Decreasing value density, skipping misfits.
+    EXACT     = 2   //!< Branch and bound for small instances.
+  };
+
+  /** Offload candidate traffic. */
+  struct Candidate
+  {
+    uint32_t teid;      //!< Traffic ID.
+    double   value;     //!< Value for offloading this traffic.
+    uint64_t bps;       //!< CPU bps required by this traffic.
+    uint32_t entries;   //!< Table entries required by this traffic.
+  };
+
+  /** Offload plan. */
+  struct Plan
+  {
+    std::vector<uint32_t> teids;    //!< Traffics to offload.
+    double                value;    //!< Total value.
+    uint64_t              bps;      //!< Total CPU bps.
+    uint32_t              entries;  //!< Total table entries.
+    bool                  fallback; //!< EXACT fell back to HEURISTIC.
+  };
+
+  /**
+   * Complete constructor.
+   * \param freeEntries The number of free table entries.
+   * \param freeBps The free CPU bps.
+   */
+  OffloadPlanner (uint32_t freeEntries, uint64_t freeBps);
+
+  /**
+   * Add a new candidate traffic.
+   * \param teid The traffic ID.
+   * \param value The value for offloading this traffic.
+   * \param bps The CPU bps required by this traffic.
+   * \param entries The table entries required by this traffic.
+   */
+  void AddCandidate (uint32_t teid, double value, uint64_t bps,
+                     uint32_t entries = 2);
+
+  /**
+   * Solve the packing problem with the given strategy. When the number of
+   * candidates exceeds the exact limit, the EXACT strategy falls back to the
+   * HEURISTIC one, and the plan reports the fallback.
+   * \param strategy The offload strategy.
+   * \param exactLimit The maximum number of candidates for the EXACT strategy.
+   * \return The offload plan.
+   */
+  Plan Solve (Strategy strategy, uint32_t exactLimit) const;
+
+  /**
+   * Get the string representing the given strategy.
+   * \param strategy The offload strategy.
+   * \return The strategy string.
+   */
+  static std::string StrategyStr (Strategy strategy);
+
+private:
+  /**
+   * Fill the plan with candidates in the given order, skipping or stopping at
+   * the first candidate that does not fit.
+   * \param order The candidates in order.
+   * \param skip True to skip misfits, false to stop at the first one.
+   * \return The offload plan.
+   */
+  Plan Fill (const std::vector<Candidate> &order, bool skip) const;
+
+  /**
+   * Recursive branch and bound search.
+   * \param order The candidates sorted by decreasing value.
+   * \param idx The current candidate index.
+   * \param current The current partial plan.
+   * \param remValue The sum of values from idx to the end.
+   * \param best The best plan found so far.
+   */
+  void Branch (const std::vector<Candidate> &order, size_t idx,
+               Plan &current, double remValue, Plan &best) const;
+
+  uint32_t                m_freeEntries;  //!< Free table entries.
+  uint64_t                m_freeBps;      //!< Free CPU bps.
+  std::vector<Candidate>  m_candidates;   //!< Candidate traffics.
+};
+
+} // namespace ns3
+#endif  // OFFLOAD_PLANNER_H
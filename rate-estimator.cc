@@ -0,0 +1,119 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Campinas (Unicamp)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Rafael G. Motta <rafaelgmotta@gmail.com>
+ *         Luciano J. Chaves <ljerezchaves@gmail.com>
+ */
+
+#include "rate-estimator.h"
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RateEstimator");
+
+RateEstimator::RateEstimator ()
+  : m_mode (RateEstimator::LIFETIME),
+  m_alpha (0.5),
+  m_totalBytes (0),
+  m_rate (0)
+{
+}
+
+void
+RateEstimator::Configure (Mode mode, double alpha, Time period, Time window,
+                          Time now)
+{
+  NS_LOG_FUNCTION (this << mode << alpha << period << window << now);
+
+  m_mode = mode;
+  m_alpha = alpha;
+  m_period = period;
+  m_window = window;
+  m_firstTime = now;
+  m_lastTime = now;
+  m_totalBytes = 0;
+  m_rate = 0;
+  m_samples.clear ();
+}
+
+void
+RateEstimator::Update (uint64_t bytes, Time now)
+{
+  NS_LOG_FUNCTION (this << bytes << now);
+
+  Time interval = now - m_lastTime;
+  if (!interval.IsStrictlyPositive ())
+    {
+      return;
+    }
+
+  m_totalBytes += bytes;
+  switch (m_mode)
+    {
+    case RateEstimator::LIFETIME:
+      {
+        m_rate = m_totalBytes * 8 / (now - m_firstTime).GetSeconds ();
+        break;
+      }
+    case RateEstimator::EWMA:
+      {
+        // The first sample initializes the average. Samples arrive at
+        // irregular intervals, so the weight is scaled by the interval length
+        // to keep the same time constant as one sample per period.
+        double sample = bytes * 8 / interval.GetSeconds ();
+        bool first = m_lastTime == m_firstTime;
+        double weight = m_alpha;
+        if (m_period.IsStrictlyPositive ())
+          {
+            weight = 1 - std::pow (1 - m_alpha, interval.GetSeconds () /
+                                   m_period.GetSeconds ());
+          }
+        m_rate = first ? sample : weight * sample + (1 - weight) * m_rate;
+        break;
+      }
+    case RateEstimator::WINDOW:
+      {
+        // Each sample covers the interval since the previous one. Discard the
+        // samples that begin before the window, but always keep the newest.
+        m_samples.push_back (std::make_pair (m_lastTime, bytes));
+        while (m_samples.size () > 1
+               && m_samples.front ().first < now - m_window)
+          {
+            m_samples.pop_front ();
+          }
+
+        uint64_t windowBytes = 0;
+        for (auto const &sample : m_samples)
+          {
+            windowBytes += sample.second;
+          }
+        Time length = now - m_samples.front ().first;
+        m_rate = windowBytes * 8 / length.GetSeconds ();
+        break;
+      }
+    }
+  m_lastTime = now;
+}
+
+DataRate
+RateEstimator::GetRate () const
+{
+  return DataRate (static_cast<uint64_t> (m_rate));
+}
+
+} // namespace ns3
@@ -0,0 +1,86 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Campinas (Unicamp)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Rafael G. Motta <rafaelgmotta@gmail.com>
+ *         Luciano J. Chaves <ljerezchaves@gmail.com>
+ */
+
+#ifndef RATE_ESTIMATOR_H
+#define RATE_ESTIMATOR_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <deque>
+
+namespace ns3 {
+
+/**
+ * This helper estimates the traffic throughput from the byte count deltas
+ * observed between consecutive polls of the switch flow entries.
+ */
+class RateEstimator
+{
+public:
+  /** Estimation mode. */
+  enum Mode
+  {
+    LIFETIME = 0,   //!< Total bytes over the traffic lifetime.
+    EWMA     = 1,   //!< Exponentially weighted moving average.
+    WINDOW   = 2    //!< Bytes within a sliding time window.
+  };
+
+  RateEstimator ();   //!< Default constructor.
+
+  /**
+   * Configure the estimator and reset its internal state.
+   * \param mode The estimation mode.
+   * \param alpha The EWMA weight for a sample covering one period.
+   * \param period The EWMA reference sampling period.
+   * \param window The sliding window length.
+   * \param now The current time.
+   */
+  void Configure (Mode mode, double alpha, Time period, Time window, Time now);
+
+  /**
+   * Feed the estimator with a new sample.
+   * \param bytes The bytes observed since the last sample.
+   * \param now The current time.
+   */
+  void Update (uint64_t bytes, Time now);
+
+  /**
+   * Get the current rate estimation.
+   * \return The estimated rate.
+   */
+  DataRate GetRate () const;
+
+private:
+  Mode      m_mode;         //!< Estimation mode.
+  double    m_alpha;        //!< EWMA weight.
+  Time      m_period;       //!< EWMA reference period.
+  Time      m_window;       //!< Sliding window length.
+  Time      m_firstTime;    //!< First sample time.
+  Time      m_lastTime;     //!< Last sample time.
+  uint64_t  m_totalBytes;   //!< Total bytes.
+  double    m_rate;         //!< Current estimation (bps).
+
+  /** Samples within the sliding window (interval start time, bytes). */
+  std::deque<std::pair<Time, uint64_t> > m_samples;
+};
+
+} // namespace ns3
+#endif  // RATE_ESTIMATOR_H
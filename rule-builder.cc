@@ -0,0 +1,558 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Campinas (Unicamp)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Rafael G. Motta <rafaelgmotta@gmail.com>
+ *         Luciano J. Chaves <ljerezchaves@gmail.com>
+ */
+
+#include "rule-builder.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RuleBuilder");
+
+// ------------------------------------------------------------------------ //
+FlowModBuilder::FlowModBuilder (enum ofp_flow_mod_command command,
+                                uint8_t table, uint16_t priority)
+{
+  // Same default values used by dpctl when parsing flow-mod commands.
+  m_msg = (struct ofl_msg_flow_mod*)xcalloc (1, sizeof (struct ofl_msg_flow_mod));
+  m_msg->header.type = OFPT_FLOW_MOD;
+  m_msg->cookie = 0;
+  m_msg->cookie_mask = 0;
+  m_msg->table_id = table;
+  m_msg->command = command;
+  m_msg->idle_timeout = OFP_FLOW_PERMANENT;
+  m_msg->hard_timeout = OFP_FLOW_PERMANENT;
+  m_msg->priority = priority;
+  m_msg->buffer_id = OFP_NO_BUFFER;
+  m_msg->out_port = OFPP_ANY;
+  m_msg->out_group = OFPG_ANY;
+  m_msg->flags = 0;
+  m_msg->instructions_num = 0;
+  m_msg->instructions = 0;
+
+  struct ofl_match *match = (struct ofl_match*)xmalloc (sizeof (struct ofl_match));
+  ofl_structs_match_init (match);
+  m_msg->match = (struct ofl_match_header*)match;
+}
+
+FlowModBuilder::~FlowModBuilder ()
+{
+  if (m_msg)
+    {
+      ofl_msg_free ((struct ofl_msg_header*)m_msg, 0);
+    }
+}
+
+FlowModBuilder&
+FlowModBuilder::SetTable (uint8_t value)
+{
+  m_msg->table_id = value;
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::SetPriority (uint16_t value)
+{
+  m_msg->priority = value;
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::SetCookie (uint64_t value, uint64_t mask)
+{
+  m_msg->cookie = value;
+  m_msg->cookie_mask = mask;
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::SetBufferId (uint32_t value)
+{
+  m_msg->buffer_id = value;
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::SetFlags (uint16_t value)
+{
+  m_msg->flags = value;
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::MatchInPort (uint32_t value)
+{
+  ofl_structs_match_put32 (GetMatch (), OXM_OF_IN_PORT, value);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::MatchEthType (uint16_t value)
+{
+  ofl_structs_match_put16 (GetMatch (), OXM_OF_ETH_TYPE, value);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::MatchIpProto (uint8_t value)
+{
+  ofl_structs_match_put8 (GetMatch (), OXM_OF_IP_PROTO, value);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::MatchIpDscp (uint8_t value)
+{
+  ofl_structs_match_put8 (GetMatch (), OXM_OF_IP_DSCP, value);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::MatchIpv4Src (Ipv4Address value, Ipv4Mask mask)
+{
+  // The oflib library expects IP addresses in network byte order.
+  if (mask == Ipv4Mask::GetOnes ())
+    {
+      ofl_structs_match_put32 (GetMatch (), OXM_OF_IPV4_SRC,
+                               htonl (value.Get ()));
+    }
+  else
+    {
+      ofl_structs_match_put32m (GetMatch (), OXM_OF_IPV4_SRC_W,
+                                htonl (value.Get ()), htonl (mask.Get ()));
+    }
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::MatchIpv4Dst (Ipv4Address value, Ipv4Mask mask)
+{
+  // The oflib library expects IP addresses in network byte order.
+  if (mask == Ipv4Mask::GetOnes ())
+    {
+      ofl_structs_match_put32 (GetMatch (), OXM_OF_IPV4_DST,
+                               htonl (value.Get ()));
+    }
+  else
+    {
+      ofl_structs_match_put32m (GetMatch (), OXM_OF_IPV4_DST_W,
+                                htonl (value.Get ()), htonl (mask.Get ()));
+    }
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::MatchTcpSrc (uint16_t value)
+{
+  ofl_structs_match_put16 (GetMatch (), OXM_OF_TCP_SRC, value);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::MatchTcpDst (uint16_t value)
+{
+  ofl_structs_match_put16 (GetMatch (), OXM_OF_TCP_DST, value);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::MatchUdpSrc (uint16_t value)
+{
+  ofl_structs_match_put16 (GetMatch (), OXM_OF_UDP_SRC, value);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::MatchUdpDst (uint16_t value)
+{
+  ofl_structs_match_put16 (GetMatch (), OXM_OF_UDP_DST, value);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::GotoTable (uint8_t value)
+{
+  struct ofl_instruction_goto_table *inst =
+    (struct ofl_instruction_goto_table*)xmalloc (
+      sizeof (struct ofl_instruction_goto_table));
+  inst->header.type = OFPIT_GOTO_TABLE;
+  inst->table_id = value;
+  AddInstruction ((struct ofl_instruction_header*)inst);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::Meter (uint32_t value)
+{
+  struct ofl_instruction_meter *inst =
+    (struct ofl_instruction_meter*)xmalloc (
+      sizeof (struct ofl_instruction_meter));
+  inst->header.type = OFPIT_METER;
+  inst->meter_id = value;
+  AddInstruction ((struct ofl_instruction_header*)inst);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::ApplyOutput (uint32_t value)
+{
+  struct ofl_action_output *act =
+    (struct ofl_action_output*)xmalloc (sizeof (struct ofl_action_output));
+  act->header.type = OFPAT_OUTPUT;
+  act->port = value;
+  act->max_len = 0;
+  AddAction (OFPIT_APPLY_ACTIONS, (struct ofl_action_header*)act);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::ApplyGroup (uint32_t value)
+{
+  struct ofl_action_group *act =
+    (struct ofl_action_group*)xmalloc (sizeof (struct ofl_action_group));
+  act->header.type = OFPAT_GROUP;
+  act->group_id = value;
+  AddAction (OFPIT_APPLY_ACTIONS, (struct ofl_action_header*)act);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::WriteOutput (uint32_t value)
+{
+  struct ofl_action_output *act =
+    (struct ofl_action_output*)xmalloc (sizeof (struct ofl_action_output));
+  act->header.type = OFPAT_OUTPUT;
+  act->port = value;
+  act->max_len = 0;
+  AddAction (OFPIT_WRITE_ACTIONS, (struct ofl_action_header*)act);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::WriteGroup (uint32_t value)
+{
+  struct ofl_action_group *act =
+    (struct ofl_action_group*)xmalloc (sizeof (struct ofl_action_group));
+  act->header.type = OFPAT_GROUP;
+  act->group_id = value;
+  AddAction (OFPIT_WRITE_ACTIONS, (struct ofl_action_header*)act);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::ApplyQueue (uint32_t value)
+{
+  struct ofl_action_set_queue *act =
+    (struct ofl_action_set_queue*)xmalloc (sizeof (struct ofl_action_set_queue));
+  act->header.type = OFPAT_SET_QUEUE;
+  act->queue_id = value;
+  AddAction (OFPIT_APPLY_ACTIONS, (struct ofl_action_header*)act);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::WriteQueue (uint32_t value)
+{
+  struct ofl_action_set_queue *act =
+    (struct ofl_action_set_queue*)xmalloc (sizeof (struct ofl_action_set_queue));
+  act->header.type = OFPAT_SET_QUEUE;
+  act->queue_id = value;
+  AddAction (OFPIT_WRITE_ACTIONS, (struct ofl_action_header*)act);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::WriteDscp (uint8_t value)
+{
+  // The set-field action owns the TLV and its value buffer.
+  struct ofl_match_tlv *field =
+    (struct ofl_match_tlv*)xmalloc (sizeof (struct ofl_match_tlv));
+  field->header = OXM_OF_IP_DSCP;
+  field->value = (uint8_t*)xmalloc (sizeof (uint8_t));
+  *field->value = value;
+
+  struct ofl_action_set_field *act =
+    (struct ofl_action_set_field*)xmalloc (sizeof (struct ofl_action_set_field));
+  act->header.type = OFPAT_SET_FIELD;
+  act->field = field;
+  AddAction (OFPIT_WRITE_ACTIONS, (struct ofl_action_header*)act);
+  return *this;
+}
+
+FlowModBuilder&
+FlowModBuilder::ApplyController (uint16_t maxLen)
+{
+  struct ofl_action_output *act =
+    (struct ofl_action_output*)xmalloc (sizeof (struct ofl_action_output));
+  act->header.type = OFPAT_OUTPUT;
+  act->port = OFPP_CONTROLLER;
+  act->max_len = maxLen;
+  AddAction (OFPIT_APPLY_ACTIONS, (struct ofl_action_header*)act);
+  return *this;
+}
+
+struct ofl_msg_header *
+FlowModBuilder::Release ()
+{
+  NS_ASSERT_MSG (m_msg, "Message already released.");
+
+  struct ofl_msg_header *msg = (struct ofl_msg_header*)m_msg;
+  m_msg = 0;
+  return msg;
+}
+
+struct ofl_match *
+FlowModBuilder::GetMatch ()
+{
+  NS_ASSERT_MSG (m_msg, "Message already released.");
+
+  return (struct ofl_match*)m_msg->match;
+}
+
+void
+FlowModBuilder::AddAction (enum ofp_instruction_type type,
+                           struct ofl_action_header *action)
+{
+  NS_ASSERT_MSG (m_msg, "Message already released.");
+
+  // Look for an existing instruction of this type to append the action.
+  struct ofl_instruction_actions *inst = 0;
+  for (size_t i = 0; i < m_msg->instructions_num; i++)
+    {
+      if (m_msg->instructions [i]->type == type)
+        {
+          inst = (struct ofl_instruction_actions*)m_msg->instructions [i];
+          break;
+        }
+    }
+
+  if (!inst)
+    {
+      inst = (struct ofl_instruction_actions*)xmalloc (
+          sizeof (struct ofl_instruction_actions));
+      inst->header.type = type;
+      inst->actions_num = 0;
+      inst->actions = 0;
+      AddInstruction ((struct ofl_instruction_header*)inst);
+    }
+
+  inst->actions = (struct ofl_action_header**)xrealloc (
+      inst->actions, (inst->actions_num + 1) * sizeof (struct ofl_action_header*));
+  inst->actions [inst->actions_num++] = action;
+}
+
+void
+FlowModBuilder::AddInstruction (struct ofl_instruction_header *inst)
+{
+  NS_ASSERT_MSG (m_msg, "Message already released.");
+
+  m_msg->instructions = (struct ofl_instruction_header**)xrealloc (
+      m_msg->instructions,
+      (m_msg->instructions_num + 1) * sizeof (struct ofl_instruction_header*));
+  m_msg->instructions [m_msg->instructions_num++] = inst;
+}
+
+
+// ------------------------------------------------------------------------ //
+GroupModBuilder::GroupModBuilder (enum ofp_group_mod_command command,
+                                  enum ofp_group_type type, uint32_t group)
+{
+  m_msg = (struct ofl_msg_group_mod*)xcalloc (1, sizeof (struct ofl_msg_group_mod));
+  m_msg->header.type = OFPT_GROUP_MOD;
+  m_msg->command = command;
+  m_msg->type = type;
+  m_msg->group_id = group;
+
+  // Single bucket with same defaults used by dpctl.
+  struct ofl_bucket *bucket =
+    (struct ofl_bucket*)xmalloc (sizeof (struct ofl_bucket));
+  bucket->weight = 0;
+  bucket->watch_port = OFPP_ANY;
+  bucket->watch_group = OFPG_ANY;
+  bucket->actions_num = 0;
+  bucket->actions = 0;
+
+  m_msg->buckets_num = 1;
+  m_msg->buckets = (struct ofl_bucket**)xmalloc (sizeof (struct ofl_bucket*));
+  m_msg->buckets [0] = bucket;
+}
+
+GroupModBuilder::~GroupModBuilder ()
+{
+  if (m_msg)
+    {
+      ofl_msg_free ((struct ofl_msg_header*)m_msg, 0);
+    }
+}
+
+GroupModBuilder&
+GroupModBuilder::Output (uint32_t port)
+{
+  NS_ASSERT_MSG (m_msg, "Message already released.");
+
+  struct ofl_action_output *act =
+    (struct ofl_action_output*)xmalloc (sizeof (struct ofl_action_output));
+  act->header.type = OFPAT_OUTPUT;
+  act->port = port;
+  act->max_len = 0;
+
+  struct ofl_bucket *bucket = m_msg->buckets [0];
+  bucket->actions = (struct ofl_action_header**)xrealloc (
+      bucket->actions, (bucket->actions_num + 1) * sizeof (struct ofl_action_header*));
+  bucket->actions [bucket->actions_num++] = (struct ofl_action_header*)act;
+  return *this;
+}
+
+struct ofl_msg_header *
+GroupModBuilder::Release ()
+{
+  NS_ASSERT_MSG (m_msg, "Message already released.");
+
+  struct ofl_msg_header *msg = (struct ofl_msg_header*)m_msg;
+  m_msg = 0;
+  return msg;
+}
+
+
+// ------------------------------------------------------------------------ //
+MeterModBuilder::MeterModBuilder (enum ofp_meter_mod_command command,
+                                  uint32_t meter)
+{
+  // Same flags used by dpctl when parsing meter-mod commands with kbps rates.
+  m_msg = (struct ofl_msg_meter_mod*)xcalloc (1, sizeof (struct ofl_msg_meter_mod));
+  m_msg->header.type = OFPT_METER_MOD;
+  m_msg->command = command;
+  m_msg->flags = OFPMF_KBPS | OFPMF_BURST;
+  m_msg->meter_id = meter;
+  m_msg->meter_bands_num = 0;
+  m_msg->bands = 0;
+}
+
+MeterModBuilder::~MeterModBuilder ()
+{
+  if (m_msg)
+    {
+      ofl_msg_free ((struct ofl_msg_header*)m_msg, 0);
+    }
+}
+
+MeterModBuilder&
+MeterModBuilder::Drop (uint32_t rate, uint32_t burst)
+{
+  struct ofl_meter_band_drop *band =
+    (struct ofl_meter_band_drop*)xmalloc (sizeof (struct ofl_meter_band_drop));
+  band->type = OFPMBT_DROP;
+  band->rate = rate;
+  band->burst_size = burst;
+  AddBand ((struct ofl_meter_band_header*)band);
+  return *this;
+}
+
+MeterModBuilder&
+MeterModBuilder::DscpRemark (uint32_t rate, uint32_t burst, uint8_t precLevel)
+{
+  struct ofl_meter_band_dscp_remark *band =
+    (struct ofl_meter_band_dscp_remark*)xmalloc (
+      sizeof (struct ofl_meter_band_dscp_remark));
+  band->type = OFPMBT_DSCP_REMARK;
+  band->rate = rate;
+  band->burst_size = burst;
+  band->prec_level = precLevel;
+  AddBand ((struct ofl_meter_band_header*)band);
+  return *this;
+}
+
+struct ofl_msg_header *
+MeterModBuilder::Release ()
+{
+  NS_ASSERT_MSG (m_msg, "Message already released.");
+
+  struct ofl_msg_header *msg = (struct ofl_msg_header*)m_msg;
+  m_msg = 0;
+  return msg;
+}
+
+void
+MeterModBuilder::AddBand (struct ofl_meter_band_header *band)
+{
+  NS_ASSERT_MSG (m_msg, "Message already released.");
+
+  m_msg->bands = (struct ofl_meter_band_header**)xrealloc (
+      m_msg->bands,
+      (m_msg->meter_bands_num + 1) * sizeof (struct ofl_meter_band_header*));
+  m_msg->bands [m_msg->meter_bands_num++] = band;
+}
+
+
+// ------------------------------------------------------------------------ //
+PacketOutBuilder::PacketOutBuilder (const struct ofl_msg_packet_in *msg,
+                                    uint32_t inPort)
+{
+  m_msg = (struct ofl_msg_packet_out*)xcalloc (1, sizeof (struct ofl_msg_packet_out));
+  m_msg->header.type = OFPT_PACKET_OUT;
+  m_msg->buffer_id = msg->buffer_id;
+  m_msg->in_port = inPort;
+  m_msg->actions_num = 0;
+  m_msg->actions = 0;
+  m_msg->data_length = 0;
+  m_msg->data = 0;
+
+  // The packet data must go back to the switch only when it isn't buffered.
+  if (msg->buffer_id == OFP_NO_BUFFER)
+    {
+      m_msg->data_length = msg->data_length;
+      m_msg->data = (uint8_t*)xmemdup (msg->data, msg->data_length);
+    }
+}
+
+PacketOutBuilder::~PacketOutBuilder ()
+{
+  if (m_msg)
+    {
+      ofl_msg_free ((struct ofl_msg_header*)m_msg, 0);
+    }
+}
+
+PacketOutBuilder&
+PacketOutBuilder::Group (uint32_t group)
+{
+  NS_ASSERT_MSG (m_msg, "Message already released.");
+
+  struct ofl_action_group *act =
+    (struct ofl_action_group*)xmalloc (sizeof (struct ofl_action_group));
+  act->header.type = OFPAT_GROUP;
+  act->group_id = group;
+
+  m_msg->actions = (struct ofl_action_header**)xrealloc (
+      m_msg->actions, (m_msg->actions_num + 1) * sizeof (struct ofl_action_header*));
+  m_msg->actions [m_msg->actions_num++] = (struct ofl_action_header*)act;
+  return *this;
+}
+
+struct ofl_msg_header *
+PacketOutBuilder::Release ()
+{
+  NS_ASSERT_MSG (m_msg, "Message already released.");
+
+  struct ofl_msg_header *msg = (struct ofl_msg_header*)m_msg;
+  m_msg = 0;
+  return msg;
+}
+
+} // namespace ns3
@@ -0,0 +1,280 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Campinas (Unicamp)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Rafael G. Motta <rafaelgmotta@gmail.com>
+ *         Luciano J. Chaves <ljerezchaves@gmail.com>
+ */
+
+#ifndef RULE_BUILDER_H
+#define RULE_BUILDER_H
+
+#include <ns3/ofswitch13-module.h>
+#include <ns3/internet-module.h>
+#include <ns3/core-module.h>
+
+namespace ns3 {
+
+/**
+ * This helper builds OpenFlow flow-mod messages directly into the oflib
+ * structures, avoiding the format-then-parse round trip of dpctl commands.
+ * The builder owns the message under construction until Release () is called.
+ * After that, the caller is responsible for freeing the message with
+ * ofl_msg_free ().
+ */
+class FlowModBuilder
+{
+public:
+  /**
+   * Complete constructor.
+   * \param command The flow-mod command (OFPFC_*).
+   * \param table The table ID (OFPTT_ALL by default).
+   * \param priority The rule priority.
+   */
+  FlowModBuilder (enum ofp_flow_mod_command command = OFPFC_ADD,
+                  uint8_t table = OFPTT_ALL,
+                  uint16_t priority = OFP_DEFAULT_PRIORITY);
+  ~FlowModBuilder ();   //!< Default destructor.
+
+  /**
+   * \name Flow-mod header modifiers.
+   * \param value The value to set.
+   * \param mask The value mask.
+   * \return The builder reference for chaining.
+   */
+  //\{
+  FlowModBuilder& SetTable    (uint8_t value);
+  FlowModBuilder& SetPriority (uint16_t value);
+  FlowModBuilder& SetCookie   (uint64_t value,
+                               uint64_t mask = 0xFFFFFFFFFFFFFFFF);
+  FlowModBuilder& SetBufferId (uint32_t value);
+  FlowModBuilder& SetFlags    (uint16_t value);
+  //\}
+
+  /**
+   * \name Match field modifiers.
+   * \param value The value to match.
+   * \param mask The value mask.
+   * \return The builder reference for chaining.
+   */
+  //\{
+  FlowModBuilder& MatchInPort  (uint32_t value);
+  FlowModBuilder& MatchEthType (uint16_t value);
+  FlowModBuilder& MatchIpProto (uint8_t value);
+  FlowModBuilder& MatchIpDscp  (uint8_t value);
+  FlowModBuilder& MatchIpv4Src (Ipv4Address value,
+                                Ipv4Mask mask = Ipv4Mask::GetOnes ());
+  FlowModBuilder& MatchIpv4Dst (Ipv4Address value,
+                                Ipv4Mask mask = Ipv4Mask::GetOnes ());
+  FlowModBuilder& MatchTcpSrc  (uint16_t value);
+  FlowModBuilder& MatchTcpDst  (uint16_t value);
+  FlowModBuilder& MatchUdpSrc  (uint16_t value);
+  FlowModBuilder& MatchUdpDst  (uint16_t value);
+  //\}
+
+  /**
+   * \name Instruction modifiers.
+   * \param value The instruction argument.
+   * \return The builder reference for chaining.
+   */
+  //\{
+  FlowModBuilder& GotoTable   (uint8_t value);
+  FlowModBuilder& Meter       (uint32_t value);
+  FlowModBuilder& ApplyOutput (uint32_t value);
+  FlowModBuilder& ApplyGroup  (uint32_t value);
+  FlowModBuilder& WriteOutput (uint32_t value);
+  FlowModBuilder& WriteGroup  (uint32_t value);
+  FlowModBuilder& ApplyQueue  (uint32_t value);
+  FlowModBuilder& WriteQueue  (uint32_t value);
+  FlowModBuilder& WriteDscp   (uint8_t value);
+  //\}
+
+  /**
+   * Add an apply-actions output to the controller.
+   * \param maxLen The maximum packet length sent to the controller. Longer
+   *        packets are buffered at the switch (OFPCML_NO_BUFFER to disable).
+   * \return The builder reference for chaining.
+   */
+  FlowModBuilder& ApplyController (uint16_t maxLen);
+
+  /**
+   * Release the message built so far. The builder can't be used after this.
+   * \return The OpenFlow message.
+   */
+  struct ofl_msg_header * Release ();
+
+private:
+  /**
+   * Get the match structure for the message under construction.
+   * \return The match structure.
+   */
+  struct ofl_match * GetMatch ();
+
+  /**
+   * Add an action to the apply-actions or write-actions instruction.
+   * \param type The instruction type (OFPIT_APPLY_ACTIONS/OFPIT_WRITE_ACTIONS).
+   * \param action The action to add.
+   */
+  void AddAction (enum ofp_instruction_type type,
+                  struct ofl_action_header *action);
+
+  /**
+   * Add an instruction to the message under construction.
+   * \param inst The instruction to add.
+   */
+  void AddInstruction (struct ofl_instruction_header *inst);
+
+  // Disable copy: the builder owns the message under construction.
+  FlowModBuilder (const FlowModBuilder&);
+  FlowModBuilder& operator= (const FlowModBuilder&);
+
+  struct ofl_msg_flow_mod *m_msg;   //!< Message under construction.
+};
+
+
+/**
+ * This helper builds OpenFlow group-mod messages directly into the oflib
+ * structures. Each group created here has a single bucket. The ownership
+ * rules are the same of the FlowModBuilder class.
+ */
+class GroupModBuilder
+{
+public:
+  /**
+   * Complete constructor.
+   * \param command The group-mod command (OFPGC_*).
+   * \param type The group type (OFPGT_*).
+   * \param group The group ID.
+   */
+  GroupModBuilder (enum ofp_group_mod_command command,
+                   enum ofp_group_type type, uint32_t group);
+  ~GroupModBuilder ();  //!< Default destructor.
+
+  /**
+   * Add an output action to the group bucket.
+   * \param port The output port.
+   * \return The builder reference for chaining.
+   */
+  GroupModBuilder& Output (uint32_t port);
+
+  /**
+   * Release the message built so far. The builder can't be used after this.
+   * \return The OpenFlow message.
+   */
+  struct ofl_msg_header * Release ();
+
+private:
+  // Disable copy: the builder owns the message under construction.
+  GroupModBuilder (const GroupModBuilder&);
+  GroupModBuilder& operator= (const GroupModBuilder&);
+
+  struct ofl_msg_group_mod *m_msg;  //!< Message under construction.
+};
+
+
+/**
+ * This helper builds OpenFlow meter-mod messages directly into the oflib
+ * structures, with rates in kbps. The ownership rules are the same of the
+ * FlowModBuilder class.
+ */
+class MeterModBuilder
+{
+public:
+  /**
+   * Complete constructor.
+   * \param command The meter-mod command (OFPMC_*).
+   * \param meter The meter ID.
+   */
+  MeterModBuilder (enum ofp_meter_mod_command command, uint32_t meter);
+  ~MeterModBuilder ();  //!< Default destructor.
+
+  /**
+   * \name Meter band modifiers.
+   * \param rate The band rate (kbps).
+   * \param burst The band burst size (kbits).
+   * \param precLevel The number of drop precedence levels to add.
+   * \return The builder reference for chaining.
+   */
+  //\{
+  MeterModBuilder& Drop       (uint32_t rate, uint32_t burst);
+  MeterModBuilder& DscpRemark (uint32_t rate, uint32_t burst,
+                               uint8_t precLevel);
+  //\}
+
+  /**
+   * Release the message built so far. The builder can't be used after this.
+   * \return The OpenFlow message.
+   */
+  struct ofl_msg_header * Release ();
+
+private:
+  /**
+   * Add a band to the message under construction.
+   * \param band The band to add.
+   */
+  void AddBand (struct ofl_meter_band_header *band);
+
+  // Disable copy: the builder owns the message under construction.
+  MeterModBuilder (const MeterModBuilder&);
+  MeterModBuilder& operator= (const MeterModBuilder&);
+
+  struct ofl_msg_meter_mod *m_msg;  //!< Message under construction.
+};
+
+
+
+/**
+ * This helper builds OpenFlow packet-out messages directly into the oflib
+ * structures, releasing packets received by packet-in messages either from
+ * the switch buffer or from the packet data. A packet-out without actions
+ * drops the packet. The ownership rules are the same of the FlowModBuilder
+ * class.
+ */
+class PacketOutBuilder
+{
+public:
+  /**
+   * Complete constructor.
+   * \param msg The packet-in message with the packet to release. The packet
+   *        data is copied only when it is not buffered at the switch.
+   * \param inPort The packet input port.
+   */
+  PacketOutBuilder (const struct ofl_msg_packet_in *msg, uint32_t inPort);
+  ~PacketOutBuilder (); //!< Default destructor.
+
+  /**
+   * Add a group action to the packet-out message.
+   * \param group The group ID.
+   * \return The builder reference for chaining.
+   */
+  PacketOutBuilder& Group (uint32_t group);
+
+  /**
+   * Release the message built so far. The builder can't be used after this.
+   * \return The OpenFlow message.
+   */
+  struct ofl_msg_header * Release ();
+
+private:
+  // Disable copy: the builder owns the message under construction.
+  PacketOutBuilder (const PacketOutBuilder&);
+  PacketOutBuilder& operator= (const PacketOutBuilder&);
+
+  struct ofl_msg_packet_out *m_msg; //!< Message under construction.
+};
+
+} // namespace ns3
+#endif  // RULE_BUILDER_H
@@ -36,9 +36,6 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("TrafficHelper");
 NS_OBJECT_ENSURE_REGISTERED (TrafficHelper);
 
-// Initial port number
-uint16_t TrafficHelper::m_port = 10000;
-
 // Trace files directory
 const std::string TrafficHelper::m_videoDir = "./scratch/tccsi/movies/";
 
@@ -60,6 +57,8 @@ TrafficHelper::TrafficHelper (Ptr<CustomController> controller,
   m_controller = controller;
   m_webNode = webNode;
   m_ueNodes = ueNodes;
+  m_port = 10000;
+  m_webAliases = 0;
 }
 
 TrafficHelper::~TrafficHelper ()
@@ -506,19 +505,25 @@ TrafficHelper::ConfigureApplications ()
           int videoIdx = m_nonVidRng->GetInteger ();
           m_bufVideoHelper.SetServerAttribute (
             "TraceFilename", StringValue (GetVideoFilename (videoIdx)));
-          InstallAppDefault (m_bufVideoHelper, ueImsi + 1);
+          InstallAppDefault (
+            m_bufVideoHelper, ueImsi + 1,
+            MakeEpsBearer (EpsBearer::NGBR_VIDEO_TCP_PREMIUM, 10, false, true));
         }
 
       // HTTP webpage traffic
       if (m_nonHttpPage)
         {
-          InstallAppDefault (m_httpPageHelper, ueImsi + 2);
+          InstallAppDefault (
+            m_httpPageHelper, ueImsi + 2,
+            MakeEpsBearer (EpsBearer::NGBR_VIDEO_TCP_PREMIUM, 10, false, true));
         }
 
       // HTTP webpage traffic
       if (m_dftHttpPage)
         {
-          InstallAppDefault (m_httpPageHelper, ueImsi + 3);
+          InstallAppDefault (
+            m_httpPageHelper, ueImsi + 3,
+            MakeEpsBearer (EpsBearer::NGBR_VIDEO_TCP_DEFAULT, 15, false, true));
         }
 
       // UDP Apps
@@ -526,43 +531,57 @@ TrafficHelper::ConfigureApplications ()
       // Auto-pilot traffic
       if (m_gbrAutPilot)
         {
-          InstallAppDefault (m_autPilotHelper, ueImsi + 4);
+          InstallAppDefault (
+            m_autPilotHelper, ueImsi + 4,
+            MakeEpsBearer (EpsBearer::GBR_GAMING, 3, true, false));
         }
 
       // Auto-pilot traffic
       if (m_nonAutPilot)
         {
-          InstallAppDefault (m_autPilotHelper, ueImsi + 5);
+          InstallAppDefault (
+            m_autPilotHelper, ueImsi + 5,
+            MakeEpsBearer (EpsBearer::NGBR_IMS, 9, false, true));
         }
 
       // Open Arena game
       if (m_gbrGameOpen)
         {
-          InstallAppDefault (m_gameOpenHelper, ueImsi + 6);
+          InstallAppDefault (
+            m_gameOpenHelper, ueImsi + 6,
+            MakeEpsBearer (EpsBearer::GBR_GAMING, 4, true, false));
         }
 
       // Team Fortress game
       if (m_gbrGameTeam)
         {
-          InstallAppDefault (m_gameTeamHelper, ueImsi + 7);
+          InstallAppDefault (
+            m_gameTeamHelper, ueImsi + 7,
+            MakeEpsBearer (EpsBearer::GBR_GAMING, 4, true, false));
         }
 
       // VoIP call
       if (m_gbrVoipCall)
         {
-          InstallAppDefault (m_voipCallHelper, ueImsi + 8);
+          InstallAppDefault (
+            m_voipCallHelper, ueImsi + 8,
+            MakeEpsBearer (EpsBearer::GBR_CONV_VOICE, 2, true, false));
         }
 
       // Virtual bicycle race traffic
       if (m_nonBikeRace)
         {
-          InstallAppDefault (m_bikeRaceHelper, ueImsi + 9);
+          InstallAppDefault (
+            m_bikeRaceHelper, ueImsi + 9,
+            MakeEpsBearer (EpsBearer::NGBR_VOICE_VIDEO_GAMING, 11, false, true));
         }
 
       // GPS Team Tracking traffic
       if (m_nonGpsTrack)
         {
-          InstallAppDefault (m_gpsTrackHelper, ueImsi + 10);
+          InstallAppDefault (
+            m_gpsTrackHelper, ueImsi + 10,
+            MakeEpsBearer (EpsBearer::NGBR_VIDEO_TCP_DEFAULT, 14, false, true));
         }
 
       // Live video streaming
@@ -571,7 +590,9 @@ TrafficHelper::ConfigureApplications ()
           int videoIdx = m_gbrVidRng->GetInteger ();
           m_livVideoHelper.SetServerAttribute (
             "TraceFilename", StringValue (GetVideoFilename (videoIdx)));
-          InstallAppDefault (m_livVideoHelper, ueImsi + 11);
+          InstallAppDefault (
+            m_livVideoHelper, ueImsi + 11,
+            MakeEpsBearer (EpsBearer::GBR_NON_CONV_VIDEO, 5, true, false));
         }
 
       // Live video streaming
@@ -580,20 +601,55 @@ TrafficHelper::ConfigureApplications ()
           int videoIdx = m_nonVidRng->GetInteger ();
           m_livVideoHelper.SetServerAttribute (
             "TraceFilename", StringValue (GetVideoFilename (videoIdx)));
-          InstallAppDefault (m_livVideoHelper, ueImsi + 12);
+          InstallAppDefault (
+            m_livVideoHelper, ueImsi + 12,
+            MakeEpsBearer (EpsBearer::NGBR_VOICE_VIDEO_GAMING, 11, false, true));
         }
     }
   t_ueManager = 0;
   t_ueNode = 0;
 }
 
+Ipv4Address
+TrafficHelper::GetServerNetwork (Ipv4Mask &mask)
+{
+  mask = Ipv4Mask ("255.255.0.0");
+  return Ipv4Address ("10.255.0.0");
+}
+
 uint16_t
 TrafficHelper::GetNextPortNo ()
 {
-  NS_ABORT_MSG_IF (m_port == 0xFFFF, "No more ports available for use.");
+  // Each application gets its own port on the server address, so a large
+  // number of clients spreads the applications over more server addresses.
+  if (m_port == 0xFFFF)
+    {
+      AddServerAddress ();
+    }
   return m_port++;
 }
 
+void
+TrafficHelper::AddServerAddress ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Ipv4Mask mask;
+  Ipv4Address network = GetServerNetwork (mask);
+  NS_ABORT_MSG_IF (++m_webAliases >= ~mask.Get (),
+                   "No more server addresses available for use.");
+
+  // The new address keeps the server interface mask, so clients still reach
+  // it on-link. The controller routes the whole network to the server.
+  Ptr<Ipv4> ipv4 = m_webNode->GetObject<Ipv4> ();
+  int32_t ifIndex = ipv4->GetInterfaceForDevice (m_webNode->GetDevice (1));
+  Ipv4Mask ifMask = ipv4->GetAddress (ifIndex, 0).GetMask ();
+  m_webAddr = Ipv4Address (network.Get () + m_webAliases);
+  ipv4->AddAddress (ifIndex, Ipv4InterfaceAddress (m_webAddr, ifMask));
+  m_port = 10000;
+  NS_LOG_INFO ("Server address " << m_webAddr << " added.");
+}
+
 const std::string
 TrafficHelper::GetVideoFilename (uint8_t idx)
 {
@@ -601,16 +657,30 @@ TrafficHelper::GetVideoFilename (uint8_t idx)
 }
 
 void
-TrafficHelper::InstallAppDefault (ApplicationHelper& helper, uint32_t teid)
+TrafficHelper::InstallAppDefault (ApplicationHelper& helper, uint32_t teid,
+                                  EpsBearer bearer)
 {
   NS_LOG_FUNCTION (this);
 
-  // Create the client and server applications.
-  uint16_t port = 10000 + teid;
+  // Create the client and server applications. Ports are allocated
+  // sequentially, as the TEID may not fit the 16-bit port number.
+  uint16_t port = GetNextPortNo ();
   Ptr<SvelteClient> clientApp = helper.Install (
       t_ueNode, m_webNode, t_ueAddr, m_webAddr, port);
   clientApp->SetTeid (teid);
+  clientApp->SetEpsBearer (bearer);
   t_ueManager->AddSvelteClient (clientApp);
 }
 
+EpsBearer
+TrafficHelper::MakeEpsBearer (EpsBearer::Qci qci, uint8_t level,
+                              bool capability, bool vulnerability)
+{
+  EpsBearer bearer (qci);
+  bearer.arp.priorityLevel = level;
+  bearer.arp.preemptionCapability = capability;
+  bearer.arp.preemptionVulnerability = vulnerability;
+  return bearer;
+}
+
 } // namespace ns3
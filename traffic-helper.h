@@ -57,6 +57,16 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /**
+   * Get the network for additional server addresses. Each server address has
+   * its own port space, so the server gets more addresses from this network
+   * when the applications exceed the ports of a single one. The topology must
+   * route this network to the server node.
+   * \param mask The network mask.
+   * \return The network address.
+   */
+  static Ipv4Address GetServerNetwork (Ipv4Mask &mask);
+
 protected:
   /** Destructor implementation. */
   virtual void DoDispose ();
@@ -87,10 +97,17 @@ private:
   void ConfigureHelpers ();
 
   /**
-   * Get the next port number available for use.
+   * Get the next port number available for use at the current server
+   * address, moving to a new server address when this one runs out of ports.
    * \return The port number to use.
    */
-  static uint16_t GetNextPortNo ();
+  uint16_t GetNextPortNo ();
+
+  /**
+   * Add a new address to the server node from the server network and use it
+   * for the next applications.
+   */
+  void AddServerAddress ();
 
   /**
    * Get complete filename for video trace files.
@@ -100,16 +117,30 @@ private:
   static const std::string GetVideoFilename (uint8_t idx);
 
   /**
-   * Create the pair of client/server applications and install them into UE,
-   * using the default EPS bearer for this traffic.
+   * Create the pair of client/server applications and install them into UE.
    * \param helper The reference to the application helper.
    * \param teid The TEID for this application.
+   * \param bearer The EPS bearer for this application.
+   */
+  void InstallAppDefault (ApplicationHelper& helper, uint32_t teid,
+                          EpsBearer bearer);
+
+  /**
+   * Create an EPS bearer with the given QCI and allocation and retention
+   * priority.
+   * \param qci The QoS class identifier.
+   * \param level The ARP priority level (1 is the highest priority).
+   * \param capability The ARP preemption capability.
+   * \param vulnerability The ARP preemption vulnerability.
+   * \return The EPS bearer.
    */
-  void InstallAppDefault (ApplicationHelper& helper, uint32_t teid);
+  static EpsBearer MakeEpsBearer (EpsBearer::Qci qci, uint8_t level,
+                                  bool capability, bool vulnerability);
 
   // Traffic helper.
   Ptr<CustomController>       m_controller;       //!< OpenFlow controller.
-  static uint16_t             m_port;             //!< Port numbers for apps.
+  uint16_t                    m_port;             //!< Port numbers for apps.
+  uint32_t                    m_webAliases;       //!< Server addresses added.
 
   // Traffic manager.
   ObjectFactory               m_managerFac;       //!< Traffic manager factory.
@@ -115,6 +115,38 @@ TrafficManager::SetImsi (uint64_t imsi)
   m_imsi = imsi;
 }
 
+Time
+TrafficManager::GetDeferredDeadline (Ptr<SvelteClient> app) const
+{
+  NS_LOG_FUNCTION (this << app);
+
+  // The 8 seconds interval is the same minimum interval between two
+  // consecutive start attempts enforced by SetNextAppStartTry.
+  Time deadline = GetNextAppStartTry (app) - Seconds (8);
+  if (!m_stopAppsAt.IsZero ())
+    {
+      deadline = std::min (deadline, m_stopAppsAt);
+    }
+  return deadline;
+}
+
+void
+TrafficManager::AppStartDeferred (Ptr<SvelteClient> app)
+{
+  NS_LOG_FUNCTION (this << app);
+
+  NS_ASSERT_MSG (!app->IsActive (), "Can't start an active application.");
+
+  // Reduce the maximum traffic duration by the time spent waiting.
+  Time maxOnTime = GetNextAppStartTry (app) - Simulator::Now () - Seconds (5);
+  app->SetAttribute ("MaxOnTime", TimeValue (maxOnTime));
+
+  // Schedule the application start for +1 second.
+  Simulator::Schedule (Seconds (1), &SvelteClient::Start, app);
+  NS_LOG_INFO ("Deferred app " << app->GetNameTeid () <<
+               " will start in +1 sec.");
+}
+
 void
 TrafficManager::DoDispose ()
 {
@@ -169,7 +201,9 @@ TrafficManager::AppStartTry (Ptr<SvelteClient> app)
       authorized = m_ctrlApp->DedicatedBearerRequest (app, m_imsi);
     }
 
-  // No retries are performed for a non-authorized traffic.
+  // No retries are performed for a non-authorized traffic. The controller may
+  // still hold the request in its admission queue and start the application
+  // later through AppStartDeferred.
   if (authorized)
     {
       // Schedule the application start for +1 second.
@@ -67,6 +67,23 @@ public:
    */
   void SetImsi (uint64_t imsi);
 
+  /**
+   * Get the latest time to start an application whose bearer request is
+   * waiting in the controller admission queue, still respecting the minimum
+   * traffic duration before its next start attempt.
+   * \param app The application pointer.
+   * \return The absolute deadline.
+   */
+  Time GetDeferredDeadline (Ptr<SvelteClient> app) const;
+
+  /**
+   * Start an application whose bearer request was admitted after waiting in
+   * the controller admission queue. The maximum traffic duration is reduced
+   * by the waiting time, keeping the next start attempt unchanged.
+   * \param app The application pointer.
+   */
+  void AppStartDeferred (Ptr<SvelteClient> app);
+
 protected:
   /** Destructor implementation. */
   virtual void DoDispose ();
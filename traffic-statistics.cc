@@ -18,6 +18,7 @@
  * Author: Luciano Chaves <luciano@lrc.ic.unicamp.br>
  */
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <string>
@@ -38,14 +39,62 @@ TrafficStatistics::TrafficStatistics ()
   // Clear adm and drp stats.
   memset (&m_admStats, 0, sizeof (AdmStats));
   memset (&m_drpStats, 0, sizeof (DropStats));
+  memset (&m_ctlStats, 0, sizeof (CtrlStats));
+  memset (m_clsStats, 0, sizeof (m_clsStats));
+  memset (&m_lastReb, 0, sizeof (m_lastReb));
+
+  // One drop counter for each internal priority queue on switch ports.
+  TypeId::AttributeInformation info;
+  TypeId::LookupByName ("ns3::OFSwitch13Queue")
+  .LookupAttributeByName ("NumQueues", &info);
+  uint32_t numQueues = DynamicCast<const UintegerValue> (
+      info.initialValue)->Get ();
+  m_tempPrioDrp.assign (numQueues, 0);
+  m_totalPrioDrp.assign (numQueues, 0);
 
   // Connect this stats calculator to required trace sources.
   Config::Connect (
     "/NodeList/*/ApplicationList/*/$ns3::CustomController/Request",
     MakeCallback (&TrafficStatistics::NotifyRequest, this));
+  Config::Connect (
+    "/NodeList/*/ApplicationList/*/$ns3::CustomController/Overflow",
+    MakeCallback (&TrafficStatistics::NotifyOverflow, this));
+  Config::Connect (
+    "/NodeList/*/ApplicationList/*/$ns3::CustomController/AdmissionWait",
+    MakeCallback (&TrafficStatistics::NotifyAdmissionWait, this));
+  Config::Connect (
+    "/NodeList/*/ApplicationList/*/$ns3::CustomController/Preemption",
+    MakeCallback (&TrafficStatistics::NotifyPreemption, this));
   Config::Connect (
     "/NodeList/*/ApplicationList/*/$ns3::CustomController/Release",
     MakeCallback (&TrafficStatistics::NotifyRelease, this));
+  Config::Connect (
+    "/NodeList/*/ApplicationList/*/$ns3::CustomController/RuleBatch",
+    MakeCallback (&TrafficStatistics::NotifyRuleBatch, this));
+  Config::Connect (
+    "/NodeList/*/ApplicationList/*/$ns3::CustomController/ReleaseDeletes",
+    MakeCallback (&TrafficStatistics::NotifyReleaseDeletes, this));
+  Config::Connect (
+    "/NodeList/*/ApplicationList/*/$ns3::CustomController/PacketIn",
+    MakeCallback (&TrafficStatistics::NotifyPacketIn, this));
+  Config::Connect (
+    "/NodeList/*/ApplicationList/*/$ns3::CustomController/RuleSetup",
+    MakeCallback (&TrafficStatistics::NotifyRuleSetup, this));
+  Config::Connect (
+    "/NodeList/*/ApplicationList/*/$ns3::CustomController/OffloadPlan",
+    MakeCallback (&TrafficStatistics::NotifyOffloadPlan, this));
+  Config::Connect (
+    "/NodeList/*/ApplicationList/*/$ns3::CustomController/Rebalance",
+    MakeCallback (&TrafficStatistics::NotifyRebalance, this));
+  Config::Connect (
+    "/NodeList/*/ApplicationList/*/$ns3::CustomController/Overload",
+    MakeCallback (&TrafficStatistics::NotifyOverload, this));
+  Config::Connect (
+    "/NodeList/*/ApplicationList/*/$ns3::CustomController/Migration",
+    MakeCallback (&TrafficStatistics::NotifyMigration, this));
+  Config::Connect (
+    "/NodeList/*/ApplicationList/*/$ns3::CustomController/SwitchLoad",
+    MakeCallback (&TrafficStatistics::NotifyLoadSample, this));
   Config::Connect (
     "/NodeList/*/$ns3::OFSwitch13Device/OverloadDrop",
     MakeCallback (&TrafficStatistics::OverloadDropPacket, this));
@@ -55,6 +104,9 @@ TrafficStatistics::TrafficStatistics ()
   Config::Connect (
     "/NodeList/*/$ns3::OFSwitch13Device/PortList/*/PortQueue/Drop",
     MakeCallback (&TrafficStatistics::QueueDropPacket, this));
+  Config::Connect (
+    "/NodeList/*/$ns3::OFSwitch13Device/PortList/*/PortQueue/QueueList/*/Drop",
+    MakeCallback (&TrafficStatistics::PrioQueueDropPacket, this));
   Config::Connect (
     "/NodeList/*/ApplicationList/*/$ns3::SvelteClient/AppStop",
     MakeCallback (&TrafficStatistics::DumpTraffic, this));
@@ -89,6 +141,41 @@ TrafficStatistics::GetTypeId (void)
                    StringValue ("packet-drops"),
                    MakeStringAccessor (&TrafficStatistics::m_drpFilename),
                    MakeStringChecker ())
+    .AddAttribute ("CtlStatsFilename",
+                   "Filename for OpenFlow control message statistics.",
+                   StringValue ("control-messages"),
+                   MakeStringAccessor (&TrafficStatistics::m_ctlFilename),
+                   MakeStringChecker ())
+    .AddAttribute ("OffStatsFilename",
+                   "Filename for HW offload plan statistics.",
+                   StringValue ("offload-plans"),
+                   MakeStringAccessor (&TrafficStatistics::m_offFilename),
+                   MakeStringChecker ())
+    .AddAttribute ("RebStatsFilename",
+                   "Filename for HW/SW rebalance statistics.",
+                   StringValue ("rebalance-stats"),
+                   MakeStringAccessor (&TrafficStatistics::m_rebFilename),
+                   MakeStringChecker ())
+    .AddAttribute ("OvlStatsFilename",
+                   "Filename for switch overload statistics.",
+                   StringValue ("switch-overloads"),
+                   MakeStringAccessor (&TrafficStatistics::m_ovlFilename),
+                   MakeStringChecker ())
+    .AddAttribute ("MigStatsFilename",
+                   "Filename for HW/SW migration statistics.",
+                   StringValue ("migrations"),
+                   MakeStringAccessor (&TrafficStatistics::m_migFilename),
+                   MakeStringChecker ())
+    .AddAttribute ("ClsStatsFilename",
+                   "Filename for traffic class statistics.",
+                   StringValue ("class-stats"),
+                   MakeStringAccessor (&TrafficStatistics::m_clsFilename),
+                   MakeStringChecker ())
+    .AddAttribute ("LodStatsFilename",
+                   "Filename for switch load statistics.",
+                   StringValue ("switch-load"),
+                   MakeStringAccessor (&TrafficStatistics::m_lodFilename),
+                   MakeStringChecker ())
   ;
   return tid;
 }
@@ -115,6 +202,13 @@ TrafficStatistics::DoDispose ()
   m_admWrapper = 0;
   m_appWrapper = 0;
   m_drpWrapper = 0;
+  m_ctlWrapper = 0;
+  m_offWrapper = 0;
+  m_rebWrapper = 0;
+  m_ovlWrapper = 0;
+  m_migWrapper = 0;
+  m_clsWrapper = 0;
+  m_lodWrapper = 0;
   Object::DoDispose ();
 }
 
@@ -129,6 +223,13 @@ TrafficStatistics::NotifyConstructionCompleted (void)
   SetAttribute ("AdmStatsFilename", StringValue (prefix + m_admFilename));
   SetAttribute ("AppStatsFilename", StringValue (prefix + m_appFilename));
   SetAttribute ("DrpStatsFilename", StringValue (prefix + m_drpFilename));
+  SetAttribute ("CtlStatsFilename", StringValue (prefix + m_ctlFilename));
+  SetAttribute ("OffStatsFilename", StringValue (prefix + m_offFilename));
+  SetAttribute ("RebStatsFilename", StringValue (prefix + m_rebFilename));
+  SetAttribute ("OvlStatsFilename", StringValue (prefix + m_ovlFilename));
+  SetAttribute ("MigStatsFilename", StringValue (prefix + m_migFilename));
+  SetAttribute ("ClsStatsFilename", StringValue (prefix + m_clsFilename));
+  SetAttribute ("LodStatsFilename", StringValue (prefix + m_lodFilename));
 
   // Create the output file for admission stats.
   m_admWrapper = Create<OutputStreamWrapper> (m_admFilename + ".log", std::ios::out);
@@ -140,11 +241,18 @@ TrafficStatistics::NotifyConstructionCompleted (void)
     << " " << setw (8) << "IReque"
     << " " << setw (8) << "IAccep"
     << " " << setw (8) << "IBlock"
+    << " " << setw (8) << "ISaved"
+    << " " << setw (8) << "IDefer"
+    << " " << setw (8) << "WAvg:s"
+    << " " << setw (8) << "W95:s"
+    << " " << setw (8) << "WMax:s"
     << " " << setw (8) << "IRelea"
     << " " << setw (8) << "#Actv"
     << " " << setw (8) << "TReque"
     << " " << setw (8) << "TAccep"
     << " " << setw (8) << "TBlock"
+    << " " << setw (8) << "TSaved"
+    << " " << setw (8) << "TDefer"
     << " " << setw (8) << "TRelea"
     << std::endl;
 
@@ -173,11 +281,146 @@ TrafficStatistics::NotifyConstructionCompleted (void)
     << " " << setw (8)  << "IQueue"
     << " " << setw (8)  << "TLoad"
     << " " << setw (8)  << "TMeter"
-    << " " << setw (8)  << "TQueue"
+    << " " << setw (8)  << "TQueue";
+  for (size_t q = 0; q < m_tempPrioDrp.size (); q++)
+    {
+      *m_drpWrapper->GetStream ()
+        << " " << setw (8) << "IQ" + std::to_string (q);
+    }
+  for (size_t q = 0; q < m_totalPrioDrp.size (); q++)
+    {
+      *m_drpWrapper->GetStream ()
+        << " " << setw (8) << "TQ" + std::to_string (q);
+    }
+  *m_drpWrapper->GetStream () << std::endl;
+
+  // Create the output file for control message stats.
+  m_ctlWrapper = Create<OutputStreamWrapper> (m_ctlFilename + ".log", std::ios::out);
+
+  // Print the header in output file.
+  *m_ctlWrapper->GetStream ()
+    << boolalpha << right << fixed << setprecision (3)
+    << " " << setw (8)  << "Time:s"
+    << " " << setw (8)  << "IQueued"
+    << " " << setw (8)  << "ISent"
+    << " " << setw (8)  << "ISaved"
+    << " " << setw (8)  << "IBursts"
+    << " " << setw (8)  << "TQueued"
+    << " " << setw (8)  << "TSent"
+    << " " << setw (8)  << "TSaved"
+    << " " << setw (8)  << "TBursts"
+    << " " << setw (8)  << "IDelete"
+    << " " << setw (8)  << "ISkip"
+    << " " << setw (8)  << "TDelete"
+    << " " << setw (8)  << "TSkip"
+    << " " << setw (8)  << "IPktIn"
+    << " " << setw (8)  << "IDupIn"
+    << " " << setw (8)  << "ISet:ms"
+    << " " << setw (8)  << "TPktIn"
+    << " " << setw (8)  << "TDupIn"
+    << std::endl;
+
+  // Create the output file for offload plan stats.
+  m_offWrapper = Create<OutputStreamWrapper> (m_offFilename + ".log", std::ios::out);
+
+  // Print the header in output file.
+  *m_offWrapper->GetStream ()
+    << boolalpha << right << fixed << setprecision (3)
+    << " " << setw (8)  << "Time:s"
+    << " " << setw (10) << "Strategy"
+    << " " << setw (8)  << "Applied"
+    << " " << setw (8)  << "Fallback"
+    << " " << setw (8)  << "Moved"
+    << " " << setw (8)  << "HwTab"
+    << " " << setw (8)  << "HwCpu"
+    << std::endl;
+
+  // Create the output file for rebalance stats.
+  m_rebWrapper = Create<OutputStreamWrapper> (m_rebFilename + ".log", std::ios::out);
+
+  // Print the header in output file.
+  *m_rebWrapper->GetStream ()
+    << boolalpha << right << fixed << setprecision (3)
+    << " " << setw (8)  << "Time:s"
+    << " " << setw (8)  << "Promot"
+    << " " << setw (8)  << "Demot"
+    << " " << setw (8)  << "BHwTab"
+    << " " << setw (8)  << "BHwCpu"
+    << " " << setw (8)  << "BSwTab"
+    << " " << setw (8)  << "BSwCpu"
+    << " " << setw (8)  << "AHwTab"
+    << " " << setw (8)  << "AHwCpu"
+    << " " << setw (8)  << "ASwTab"
+    << " " << setw (8)  << "ASwCpu"
+    << " " << setw (8)  << "AHwBear"
+    << " " << setw (12) << "HwBytes"
+    << " " << setw (8)  << "Evict"
+    << " " << setw (8)  << "HitRat"
+    << " " << setw (8)  << "HwShare"
+    << std::endl;
+
+  // Create the output file for overload stats.
+  m_ovlWrapper = Create<OutputStreamWrapper> (m_ovlFilename + ".log", std::ios::out);
+
+  // Print the header in output file.
+  *m_ovlWrapper->GetStream ()
+    << boolalpha << right << fixed << setprecision (3)
+    << " " << setw (8)  << "Time:s"
+    << " " << setw (8)  << "DpId"
+    << " " << setw (8)  << "Relief:s"
+    << " " << setw (8)  << "Drops"
+    << " " << setw (8)  << "Rebal"
+    << std::endl;
+
+  // Create the output file for migration stats.
+  m_migWrapper = Create<OutputStreamWrapper> (m_migFilename + ".log", std::ios::out);
+
+  // Print the header in output file.
+  *m_migWrapper->GetStream ()
+    << boolalpha << right << fixed << setprecision (3)
+    << " " << setw (8)  << "Time:s"
+    << " " << setw (11) << "Id"
+    << " " << setw (8)  << "ToHw"
+    << " " << setw (10) << "Latency:ms"
+    << " " << setw (8)  << "SwMisses"
+    << std::endl;
+
+  // Create the output file for traffic class stats.
+  m_clsWrapper = Create<OutputStreamWrapper> (m_clsFilename + ".log", std::ios::out);
+
+  // Print the header in output file.
+  *m_clsWrapper->GetStream ()
+    << boolalpha << right << fixed << setprecision (3)
+    << " " << setw (8)  << "Time:s"
+    << " " << setw (9)  << "Class"
+    << " " << setw (8)  << "IApps"
+    << " " << setw (8)  << "IDl:ms"
+    << " " << setw (8)  << "IUl:ms"
+    << " " << setw (8)  << "IPreem"
+    << " " << setw (8)  << "TApps"
+    << " " << setw (8)  << "TDl:ms"
+    << " " << setw (8)  << "TUl:ms"
+    << " " << setw (8)  << "TPreem"
+    << std::endl;
+
+  // Create the output file for switch load stats.
+  m_lodWrapper = Create<OutputStreamWrapper> (m_lodFilename + ".log", std::ios::out);
+
+  // Print the header in output file.
+  *m_lodWrapper->GetStream ()
+    << boolalpha << right << fixed << setprecision (3)
+    << " " << setw (8)  << "Time:s"
+    << " " << setw (8)  << "DpId"
+    << " " << setw (8)  << "Sample"
+    << " " << setw (8)  << "Ewma"
+    << " " << setw (8)  << "Peak"
+    << " " << setw (8)  << "Pctl"
     << std::endl;
 
   Simulator::Schedule (Seconds (1), &TrafficStatistics::DumpAdmission, this);
   Simulator::Schedule (Seconds (1), &TrafficStatistics::DumpDrop, this);
+  Simulator::Schedule (Seconds (1), &TrafficStatistics::DumpControl, this);
+  Simulator::Schedule (Seconds (1), &TrafficStatistics::DumpClass, this);
 
   Object::NotifyConstructionCompleted ();
 }
@@ -187,16 +430,37 @@ TrafficStatistics::DumpAdmission ()
 {
   NS_LOG_FUNCTION (this);
 
+  // Waiting time distribution for requests leaving the admission queue.
+  double waitAvg = 0, wait95 = 0, waitMax = 0;
+  if (m_admWaits.size ())
+    {
+      std::sort (m_admWaits.begin (), m_admWaits.end ());
+      for (auto wait : m_admWaits)
+        {
+          waitAvg += wait;
+        }
+      waitAvg /= m_admWaits.size ();
+      wait95 = m_admWaits [(m_admWaits.size () - 1) * 95 / 100];
+      waitMax = m_admWaits.back ();
+    }
+
   *m_admWrapper->GetStream ()
     << " " << setw (8) << Simulator::Now ().GetSeconds ()
     << " " << setw (8) << m_admStats.tempRequests
     << " " << setw (8) << m_admStats.tempAccepted
     << " " << setw (8) << m_admStats.tempBlocked
+    << " " << setw (8) << m_admStats.tempSaved
+    << " " << setw (8) << m_admStats.tempDeferred
+    << " " << setw (8) << waitAvg
+    << " " << setw (8) << wait95
+    << " " << setw (8) << waitMax
     << " " << setw (8) << m_admStats.tempReleases
     << " " << setw (8) << m_admStats.activeBearers
     << " " << setw (8) << m_admStats.totalRequests
     << " " << setw (8) << m_admStats.totalAccepted
     << " " << setw (8) << m_admStats.totalBlocked
+    << " " << setw (8) << m_admStats.totalSaved
+    << " " << setw (8) << m_admStats.totalDeferred
     << " " << setw (8) << m_admStats.totalReleases
     << std::endl;
 
@@ -204,10 +468,51 @@ TrafficStatistics::DumpAdmission ()
   m_admStats.tempRequests = 0;
   m_admStats.tempAccepted = 0;
   m_admStats.tempBlocked = 0;
+  m_admStats.tempSaved = 0;
+  m_admStats.tempDeferred = 0;
+  m_admWaits.clear ();
 
   Simulator::Schedule (Seconds (1), &TrafficStatistics::DumpAdmission, this);
 }
 
+void
+TrafficStatistics::DumpClass ()
+{
+  NS_LOG_FUNCTION (this);
+
+  // Average packet delays, weighted by the packets received by each app.
+  for (int c = CustomController::ELASTIC; c <= CustomController::STREAMING; c++)
+    {
+      ClassStats &stats = m_clsStats [c];
+      *m_clsWrapper->GetStream ()
+        << " " << setw (8) << Simulator::Now ().GetSeconds ()
+        << " " << setw (9) << CustomController::TrafficClassStr (
+        static_cast<CustomController::TrafficClass> (c))
+        << " " << setw (8) << stats.tempApps
+        << " " << setw (8) << (stats.tempDlPkts ?
+                               stats.tempDlDelay * 1000 / stats.tempDlPkts : 0)
+        << " " << setw (8) << (stats.tempUlPkts ?
+                               stats.tempUlDelay * 1000 / stats.tempUlPkts : 0)
+        << " " << setw (8) << stats.tempPreempted
+        << " " << setw (8) << stats.totalApps
+        << " " << setw (8) << (stats.totalDlPkts ?
+                               stats.totalDlDelay * 1000 / stats.totalDlPkts : 0)
+        << " " << setw (8) << (stats.totalUlPkts ?
+                               stats.totalUlDelay * 1000 / stats.totalUlPkts : 0)
+        << " " << setw (8) << stats.totalPreempted
+        << std::endl;
+
+      stats.tempApps = 0;
+      stats.tempDlPkts = 0;
+      stats.tempDlDelay = 0;
+      stats.tempUlPkts = 0;
+      stats.tempUlDelay = 0;
+      stats.tempPreempted = 0;
+    }
+
+  Simulator::Schedule (Seconds (1), &TrafficStatistics::DumpClass, this);
+}
+
 void
 TrafficStatistics::DumpDrop ()
 {
@@ -220,22 +525,93 @@ TrafficStatistics::DumpDrop ()
     << " " << setw (8) << m_drpStats.tempQueue
     << " " << setw (8) << m_drpStats.totalLoad
     << " " << setw (8) << m_drpStats.totalMeter
-    << " " << setw (8) << m_drpStats.totalQueue
-    << std::endl;
+    << " " << setw (8) << m_drpStats.totalQueue;
+  for (auto const &drops : m_tempPrioDrp)
+    {
+      *m_drpWrapper->GetStream () << " " << setw (8) << drops;
+    }
+  for (auto const &drops : m_totalPrioDrp)
+    {
+      *m_drpWrapper->GetStream () << " " << setw (8) << drops;
+    }
+  *m_drpWrapper->GetStream () << std::endl;
 
   m_drpStats.tempLoad = 0;
   m_drpStats.tempMeter = 0;
   m_drpStats.tempQueue = 0;
+  std::fill (m_tempPrioDrp.begin (), m_tempPrioDrp.end (), 0);
 
   Simulator::Schedule (Seconds (1), &TrafficStatistics::DumpDrop, this);
 }
 
+void
+TrafficStatistics::DumpControl ()
+{
+  NS_LOG_FUNCTION (this);
+
+  *m_ctlWrapper->GetStream ()
+    << " " << setw (8) << Simulator::Now ().GetSeconds ()
+    << " " << setw (8) << m_ctlStats.tempQueued
+    << " " << setw (8) << m_ctlStats.tempSent
+    << " " << setw (8) << m_ctlStats.tempQueued - m_ctlStats.tempSent
+    << " " << setw (8) << m_ctlStats.tempBursts
+    << " " << setw (8) << m_ctlStats.totalQueued
+    << " " << setw (8) << m_ctlStats.totalSent
+    << " " << setw (8) << m_ctlStats.totalQueued - m_ctlStats.totalSent
+    << " " << setw (8) << m_ctlStats.totalBursts
+    << " " << setw (8) << m_ctlStats.tempDeletes
+    << " " << setw (8) << m_ctlStats.tempSkipped
+    << " " << setw (8) << m_ctlStats.totalDeletes
+    << " " << setw (8) << m_ctlStats.totalSkipped
+    << " " << setw (8) << m_ctlStats.tempPktIn
+    << " " << setw (8) << m_ctlStats.tempDupIn
+    << " " << setw (8) << (m_ctlStats.tempSetups ?
+                           m_ctlStats.tempSetupSum / m_ctlStats.tempSetups : 0)
+    << " " << setw (8) << m_ctlStats.totalPktIn
+    << " " << setw (8) << m_ctlStats.totalDupIn
+    << std::endl;
+
+  m_ctlStats.tempQueued = 0;
+  m_ctlStats.tempSent = 0;
+  m_ctlStats.tempBursts = 0;
+  m_ctlStats.tempDeletes = 0;
+  m_ctlStats.tempSkipped = 0;
+  m_ctlStats.tempPktIn = 0;
+  m_ctlStats.tempDupIn = 0;
+  m_ctlStats.tempSetups = 0;
+  m_ctlStats.tempSetupSum = 0;
+
+  Simulator::Schedule (Seconds (1), &TrafficStatistics::DumpControl, this);
+}
+
 void
 TrafficStatistics::DumpTraffic (
   std::string context, Ptr<SvelteClient> app)
 {
   NS_LOG_FUNCTION (this << context << app->GetTeidHex ());
 
+  // Accumulate the packet delays for the traffic class.
+  ClassStats &stats =
+    m_clsStats [CustomController::GetTrafficClass (app->GetTeid ())];
+  stats.tempApps++;
+  stats.totalApps++;
+
+  uint32_t packets = app->GetAppStats ()->GetRxPackets ();
+  double delay = app->GetAppStats ()->GetRxDelay ().GetSeconds () * packets;
+  stats.tempDlPkts += packets;
+  stats.totalDlPkts += packets;
+  stats.tempDlDelay += delay;
+  stats.totalDlDelay += delay;
+  if (app->GetAppName () != "LivVideo")
+    {
+      packets = app->GetServerAppStats ()->GetRxPackets ();
+      delay = app->GetServerAppStats ()->GetRxDelay ().GetSeconds () * packets;
+      stats.tempUlPkts += packets;
+      stats.totalUlPkts += packets;
+      stats.tempUlDelay += delay;
+      stats.totalUlDelay += delay;
+    }
+
   if (app->GetAppName () != "LivVideo")
     {
       // Dump uplink statistics.
@@ -279,6 +655,41 @@ TrafficStatistics::NotifyRequest (
     }
 }
 
+void
+TrafficStatistics::NotifyOverflow (
+  std::string context, uint32_t teid, uint64_t dpId)
+{
+  NS_LOG_FUNCTION (this << context << teid << dpId);
+
+  m_admStats.tempSaved++;
+  m_admStats.totalSaved++;
+}
+
+void
+TrafficStatistics::NotifyAdmissionWait (
+  std::string context, uint32_t teid, Time wait, bool admitted)
+{
+  NS_LOG_FUNCTION (this << context << teid << wait << admitted);
+
+  m_admWaits.push_back (wait.GetSeconds ());
+  if (admitted)
+    {
+      m_admStats.tempDeferred++;
+      m_admStats.totalDeferred++;
+    }
+}
+
+void
+TrafficStatistics::NotifyPreemption (
+  std::string context, uint32_t teid, uint32_t byTeid)
+{
+  NS_LOG_FUNCTION (this << context << teid << byTeid);
+
+  ClassStats &stats = m_clsStats [CustomController::GetTrafficClass (teid)];
+  stats.tempPreempted++;
+  stats.totalPreempted++;
+}
+
 void
 TrafficStatistics::NotifyRelease (
   std::string context, uint32_t teid)
@@ -290,6 +701,166 @@ TrafficStatistics::NotifyRelease (
   m_admStats.activeBearers--;
 }
 
+void
+TrafficStatistics::NotifyRuleBatch (
+  std::string context, uint64_t dpId, uint32_t queued, uint32_t sent)
+{
+  NS_LOG_FUNCTION (this << context << dpId << queued << sent);
+
+  m_ctlStats.tempQueued += queued;
+  m_ctlStats.tempSent += sent;
+  m_ctlStats.totalQueued += queued;
+  m_ctlStats.totalSent += sent;
+  if (sent)
+    {
+      m_ctlStats.tempBursts++;
+      m_ctlStats.totalBursts++;
+    }
+}
+
+void
+TrafficStatistics::NotifyReleaseDeletes (
+  std::string context, uint32_t teid, uint32_t sent, uint32_t skipped)
+{
+  NS_LOG_FUNCTION (this << context << teid << sent << skipped);
+
+  m_ctlStats.tempDeletes += sent;
+  m_ctlStats.tempSkipped += skipped;
+  m_ctlStats.totalDeletes += sent;
+  m_ctlStats.totalSkipped += skipped;
+}
+
+void
+TrafficStatistics::NotifyPacketIn (
+  std::string context, uint64_t dpId, uint32_t teid, bool duplicate)
+{
+  NS_LOG_FUNCTION (this << context << dpId << teid << duplicate);
+
+  m_ctlStats.tempPktIn++;
+  m_ctlStats.totalPktIn++;
+  if (duplicate)
+    {
+      m_ctlStats.tempDupIn++;
+      m_ctlStats.totalDupIn++;
+    }
+}
+
+void
+TrafficStatistics::NotifyRuleSetup (
+  std::string context, uint32_t teid, uint64_t dpId, Time latency)
+{
+  NS_LOG_FUNCTION (this << context << teid << dpId << latency);
+
+  m_ctlStats.tempSetups++;
+  m_ctlStats.tempSetupSum += latency.GetSeconds () * 1000;
+}
+
+void
+TrafficStatistics::NotifyOffloadPlan (
+  std::string context, std::string strategy, bool applied, bool fallback,
+  uint32_t moved, double tabUse, double cpuUse)
+{
+  NS_LOG_FUNCTION (this << context << strategy << applied << fallback <<
+                   moved);
+
+  *m_offWrapper->GetStream ()
+    << " " << setw (8)  << Simulator::Now ().GetSeconds ()
+    << " " << setw (10) << strategy
+    << " " << setw (8)  << applied
+    << " " << setw (8)  << fallback
+    << " " << setw (8)  << moved
+    << " " << setw (8)  << tabUse
+    << " " << setw (8)  << cpuUse
+    << std::endl;
+}
+
+void
+TrafficStatistics::NotifyRebalance (
+  std::string context, const CustomController::RebalanceStats &stats)
+{
+  NS_LOG_FUNCTION (this << context);
+
+  // The HW cache hit ratio (packets) and the HW traffic share (bytes) since
+  // the last rebalance.
+  uint64_t hwPkts = stats.hwPkts - m_lastReb.hwPkts;
+  uint64_t swPkts = stats.swPkts - m_lastReb.swPkts;
+  uint64_t hwBytes = stats.hwBytes - m_lastReb.hwBytes;
+  uint64_t swBytes = stats.swBytes - m_lastReb.swBytes;
+  double hitRatio = hwPkts + swPkts ?
+    static_cast<double> (hwPkts) / (hwPkts + swPkts) : 0;
+  double hwShare = hwBytes + swBytes ?
+    static_cast<double> (hwBytes) / (hwBytes + swBytes) : 0;
+  m_lastReb = stats;
+
+  *m_rebWrapper->GetStream ()
+    << " " << setw (8) << Simulator::Now ().GetSeconds ()
+    << " " << setw (8) << stats.promoted
+    << " " << setw (8) << stats.demoted
+    << " " << setw (8) << stats.hwTabBefore
+    << " " << setw (8) << stats.hwCpuBefore
+    << " " << setw (8) << stats.swTabBefore
+    << " " << setw (8) << stats.swCpuBefore
+    << " " << setw (8) << stats.hwTabAfter
+    << " " << setw (8) << stats.hwCpuAfter
+    << " " << setw (8) << stats.swTabAfter
+    << " " << setw (8) << stats.swCpuAfter
+    << " " << setw (8) << stats.hwBearers
+    << " " << setw (12) << stats.hwBytes
+    << " " << setw (8) << stats.evicted
+    << " " << setw (8) << hitRatio
+    << " " << setw (8) << hwShare
+    << std::endl;
+}
+
+void
+TrafficStatistics::NotifyOverload (
+  std::string context, uint64_t dpId, Time duration, uint32_t drops,
+  uint32_t rebalances)
+{
+  NS_LOG_FUNCTION (this << context << dpId << duration << drops << rebalances);
+
+  *m_ovlWrapper->GetStream ()
+    << " " << setw (8) << Simulator::Now ().GetSeconds ()
+    << " " << setw (8) << dpId
+    << " " << setw (8) << duration.GetSeconds ()
+    << " " << setw (8) << drops
+    << " " << setw (8) << rebalances
+    << std::endl;
+}
+
+void
+TrafficStatistics::NotifyMigration (
+  std::string context, uint32_t id, bool toHw, Time latency, uint64_t lost)
+{
+  NS_LOG_FUNCTION (this << context << id << toHw << latency << lost);
+
+  *m_migWrapper->GetStream ()
+    << " " << setw (8)  << Simulator::Now ().GetSeconds ()
+    << " " << setw (11) << GetUint32Hex (id)
+    << " " << setw (8)  << toHw
+    << " " << setw (10) << latency.GetSeconds () * 1000
+    << " " << setw (8)  << lost
+    << std::endl;
+}
+
+void
+TrafficStatistics::NotifyLoadSample (
+  std::string context, uint64_t dpId, double sample, double ewma,
+  double peak, double percentile)
+{
+  NS_LOG_FUNCTION (this << context << dpId << sample << ewma << peak
+                        << percentile);
+
+  *m_lodWrapper->GetStream ()
+    << " " << setw (8) << Simulator::Now ().GetSeconds ()
+    << " " << setw (8) << dpId
+    << " " << setw (8) << sample
+    << " " << setw (8) << ewma
+    << " " << setw (8) << peak
+    << " " << setw (8) << percentile
+    << std::endl;
+}
+
 void
 TrafficStatistics::OverloadDropPacket (
   std::string context, Ptr<const Packet> packet)
@@ -320,4 +891,21 @@ TrafficStatistics::QueueDropPacket (
   m_drpStats.totalQueue++;
 }
 
+void
+TrafficStatistics::PrioQueueDropPacket (
+  std::string context, Ptr<const Packet> packet)
+{
+  NS_LOG_FUNCTION (this << context << packet);
+
+  // The context ends with ".../QueueList/<id>/Drop".
+  std::string prefix ("/QueueList/");
+  size_t pos = context.rfind (prefix);
+  NS_ASSERT_MSG (pos != std::string::npos, "Invalid context " << context);
+  uint32_t queueId = std::stoul (context.substr (pos + prefix.size ()));
+
+  NS_ASSERT_MSG (queueId < m_tempPrioDrp.size (), "Invalid queue ID.");
+  m_tempPrioDrp [queueId]++;
+  m_totalPrioDrp [queueId]++;
+}
+
 } // Namespace ns3
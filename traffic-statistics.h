@@ -24,6 +24,7 @@
 #include <ns3/core-module.h>
 #include <ns3/network-module.h>
 #include "applications/app-stats-calculator.h"
+#include "custom-controller.h"
 
 namespace ns3 {
 
@@ -78,11 +79,15 @@ private:
     uint64_t tempRequests;      //!< Temp number of requests.
     uint64_t tempAccepted;      //!< Temp number of requests accepted.
     uint64_t tempBlocked;       //!< Temp number of requests blocked.
+    uint64_t tempSaved;         //!< Temp number of requests overflowed.
+    uint64_t tempDeferred;      //!< Temp number of requests deferred.
     uint64_t activeBearers;     //!< Number of active bearers.
     uint64_t totalReleases;     //!< Total number of releases.
     uint64_t totalRequests;     //!< Total number of requests.
     uint64_t totalAccepted;     //!< Total number of requests accepted.
     uint64_t totalBlocked;      //!< Total number of requests blocked.
+    uint64_t totalSaved;        //!< Total number of requests overflowed.
+    uint64_t totalDeferred;     //!< Total number of requests deferred.
   };
 
   /** Metadata associated to packet drops. */
@@ -96,16 +101,64 @@ private:
     uint64_t totalQueue;      //!< Total number of queue drops.
   };
 
+  /** Metadata associated to OpenFlow control messages. */
+  struct CtrlStats
+  {
+    uint64_t tempQueued;      //!< Temp number of messages queued.
+    uint64_t tempSent;        //!< Temp number of messages sent.
+    uint64_t tempBursts;      //!< Temp number of message bursts.
+    uint64_t totalQueued;     //!< Total number of messages queued.
+    uint64_t totalSent;       //!< Total number of messages sent.
+    uint64_t totalBursts;     //!< Total number of message bursts.
+    uint64_t tempDeletes;     //!< Temp number of release deletes sent.
+    uint64_t tempSkipped;     //!< Temp number of release deletes skipped.
+    uint64_t totalDeletes;    //!< Total number of release deletes sent.
+    uint64_t totalSkipped;    //!< Total number of release deletes skipped.
+    uint64_t tempPktIn;       //!< Temp number of packet-ins.
+    uint64_t tempDupIn;       //!< Temp number of duplicate packet-ins.
+    uint64_t totalPktIn;      //!< Total number of packet-ins.
+    uint64_t totalDupIn;      //!< Total number of duplicate packet-ins.
+    uint64_t tempSetups;      //!< Temp number of reactive rule setups.
+    double   tempSetupSum;    //!< Temp sum of reactive setup latencies (ms).
+  };
+
+  /** Metadata associated to traffic classes. */
+  struct ClassStats
+  {
+    uint64_t tempApps;        //!< Temp number of apps stopped.
+    uint64_t tempDlPkts;      //!< Temp number of DL packets received.
+    double   tempDlDelay;     //!< Temp sum of DL packet delays (s).
+    uint64_t tempUlPkts;      //!< Temp number of UL packets received.
+    double   tempUlDelay;     //!< Temp sum of UL packet delays (s).
+    uint64_t tempPreempted;   //!< Temp number of bearers preempted.
+    uint64_t totalApps;       //!< Total number of apps stopped.
+    uint64_t totalDlPkts;     //!< Total number of DL packets received.
+    double   totalDlDelay;    //!< Total sum of DL packet delays (s).
+    uint64_t totalUlPkts;     //!< Total number of UL packets received.
+    double   totalUlDelay;    //!< Total sum of UL packet delays (s).
+    uint64_t totalPreempted;  //!< Total number of bearers preempted.
+  };
+
   /**
    * Dump admission statistics into file.
    */
   void DumpAdmission ();
 
+  /**
+   * Dump traffic class statistics into file.
+   */
+  void DumpClass ();
+
   /**
    * Dump admission statistics into file.
    */
   void DumpDrop ();
 
+  /**
+   * Dump OpenFlow control message statistics into file.
+   */
+  void DumpControl ();
+
   /**
    * Dump traffic statistics into file.
    * Trace sink fired when application traffic stops.
@@ -122,6 +175,32 @@ private:
    */
   void NotifyRequest (std::string context, uint32_t teid, bool accepted);
 
+  /**
+   * Notify a traffic request saved from blocking by overflow routing.
+   * \param context Context information.
+   * \param teid The traffic TEID.
+   * \param dpId The datapath ID of the switch that accepted the traffic.
+   */
+  void NotifyOverflow (std::string context, uint32_t teid, uint64_t dpId);
+
+  /**
+   * Notify a traffic request leaving the admission queue.
+   * \param context Context information.
+   * \param teid The traffic TEID.
+   * \param wait The time spent in the admission queue.
+   * \param admitted True if admitted, false if expired or evicted.
+   */
+  void NotifyAdmissionWait (std::string context, uint32_t teid, Time wait,
+                            bool admitted);
+
+  /**
+   * Notify a bearer preemption.
+   * \param context Context information.
+   * \param teid The preempted traffic TEID.
+   * \param byTeid The traffic TEID admitted by preemption.
+   */
+  void NotifyPreemption (std::string context, uint32_t teid, uint32_t byTeid);
+
   /**
    * Notify a traffic release.
    * \param context Context information.
@@ -129,6 +208,102 @@ private:
    */
   void NotifyRelease (std::string context, uint32_t teid);
 
+  /**
+   * Notify a batch of OpenFlow messages sent to a switch.
+   * \param context Context information.
+   * \param dpId The switch datapath ID.
+   * \param queued The number of messages queued for this batch.
+   * \param sent The number of messages effectively sent in this batch.
+   */
+  void NotifyRuleBatch (std::string context, uint64_t dpId, uint32_t queued,
+                        uint32_t sent);
+
+  /**
+   * Notify the delete messages sent to release a traffic.
+   * \param context Context information.
+   * \param teid The traffic TEID.
+   * \param sent The number of delete messages sent.
+   * \param skipped The number of delete messages not needed.
+   */
+  void NotifyReleaseDeletes (std::string context, uint32_t teid,
+                             uint32_t sent, uint32_t skipped);
+
+  /**
+   * Notify a packet-in message received by the controller.
+   * \param context Context information.
+   * \param dpId The switch datapath ID.
+   * \param teid The traffic TEID (zero for unknown traffic).
+   * \param duplicate True when the rules were already installed.
+   */
+  void NotifyPacketIn (std::string context, uint64_t dpId, uint32_t teid,
+                       bool duplicate);
+
+  /**
+   * Notify a reactive rule setup confirmed by the switch.
+   * \param context Context information.
+   * \param teid The traffic TEID.
+   * \param dpId The switch datapath ID.
+   * \param latency The interval between the packet-in and the confirmation.
+   */
+  void NotifyRuleSetup (std::string context, uint32_t teid, uint64_t dpId,
+                        Time latency);
+
+  /**
+   * Notify an offload plan computed by the controller.
+   * \param context Context information.
+   * \param strategy The offload strategy name.
+   * \param applied True if this plan was applied, false otherwise.
+   * \param fallback True if the exact strategy fell back to the heuristic.
+   * \param moved The number of traffics in this plan.
+   * \param tabUse The HW flow table usage after this plan.
+   * \param cpuUse The HW CPU usage after this plan.
+   */
+  void NotifyOffloadPlan (std::string context, std::string strategy,
+                          bool applied, bool fallback, uint32_t moved,
+                          double tabUse, double cpuUse);
+
+  /**
+   * Notify a rebalance operation between HW and SW switches.
+   * \param context Context information.
+   * \param stats The rebalance statistics.
+   */
+  void NotifyRebalance (std::string context,
+                        const CustomController::RebalanceStats &stats);
+
+  /**
+   * Notify the relief of a switch overload.
+   * \param context Context information.
+   * \param dpId The switch datapath ID.
+   * \param duration The time from overload onset to relief.
+   * \param drops The number of packets dropped by overload in this interval.
+   * \param rebalances The number of rebalances in this interval.
+   */
+  void NotifyOverload (std::string context, uint64_t dpId, Time duration,
+                       uint32_t drops, uint32_t rebalances);
+
+  /**
+   * Notify a completed migration between HW and SW switches.
+   * \param context Context information.
+   * \param id The traffic ID or group ID.
+   * \param toHw True when moving to HW switch, false for SW switch.
+   * \param latency The migration latency.
+   * \param lost The switch-wide table misses during the migration.
+   */
+  void NotifyMigration (std::string context, uint32_t id, bool toHw,
+                        Time latency, uint64_t lost);
+
+  /**
+   * Notify a new switch load sample.
+   * \param context Context information.
+   * \param dpId The switch datapath ID.
+   * \param sample The CPU usage sample.
+   * \param ewma The EWMA CPU usage.
+   * \param peak The peak CPU usage within the window.
+   * \param percentile The percentile CPU usage within the window.
+   */
+  void NotifyLoadSample (std::string context, uint64_t dpId, double sample,
+                         double ewma, double peak, double percentile);
+
   /**
    * Trace sink fired when a packet is dropped while exceeding pipeline load
    * capacity.
@@ -153,8 +328,24 @@ private:
    */
   void QueueDropPacket (std::string context, Ptr<const Packet> packet);
 
+  /**
+   * Trace sink fired when a packet is dropped by one of the internal priority
+   * queues of OpenFlow ports. The queue ID is parsed from the context.
+   * \param context Context information.
+   * \param packet The dropped packet.
+   */
+  void PrioQueueDropPacket (std::string context, Ptr<const Packet> packet);
+
   AdmStats                  m_admStats;     //!< Admission stats.
+  std::vector<double>       m_admWaits;     //!< Temp queue waiting times.
   DropStats                 m_drpStats;
+  std::vector<uint64_t>     m_tempPrioDrp;  //!< Temp drops per queue ID.
+  std::vector<uint64_t>     m_totalPrioDrp; //!< Total drops per queue ID.
+  CtrlStats                 m_ctlStats;     //!< Control message stats.
+  ClassStats                m_clsStats [4]; //!< Traffic class stats.
+
+  /** Last rebalance stats, for the HW cache ratios between rebalances. */
+  CustomController::RebalanceStats m_lastReb;
 
   std::string               m_admFilename;  //!< AdmStats filename.
   Ptr<OutputStreamWrapper>  m_admWrapper;   //!< AdmStats file wrapper.
@@ -162,6 +353,20 @@ private:
   Ptr<OutputStreamWrapper>  m_appWrapper;   //!< AppStats file wrapper.
   std::string               m_drpFilename;  //!< DrpStats filename.
   Ptr<OutputStreamWrapper>  m_drpWrapper;   //!< DrpStats file wrapper.
+  std::string               m_ctlFilename;  //!< CtlStats filename.
+  Ptr<OutputStreamWrapper>  m_ctlWrapper;   //!< CtlStats file wrapper.
+  std::string               m_offFilename;  //!< OffStats filename.
+  Ptr<OutputStreamWrapper>  m_offWrapper;   //!< OffStats file wrapper.
+  std::string               m_rebFilename;  //!< RebStats filename.
+  Ptr<OutputStreamWrapper>  m_rebWrapper;   //!< RebStats file wrapper.
+  std::string               m_ovlFilename;  //!< OvlStats filename.
+  Ptr<OutputStreamWrapper>  m_ovlWrapper;   //!< OvlStats file wrapper.
+  std::string               m_migFilename;  //!< MigStats filename.
+  Ptr<OutputStreamWrapper>  m_migWrapper;   //!< MigStats file wrapper.
+  std::string               m_clsFilename;  //!< ClsStats filename.
+  Ptr<OutputStreamWrapper>  m_clsWrapper;   //!< ClsStats file wrapper.
+  std::string               m_lodFilename;  //!< LodStats filename.
+  Ptr<OutputStreamWrapper>  m_lodWrapper;   //!< LodStats file wrapper.
 };
 
 } // namespace ns3